@@ -1,1171 +1,330 @@
 // Maciej Szakowski
-// it takes C++ source files and produces monolithic header and source file 
-// IR is the intermediate representation of all cpp modules that can be dumped to one monolithic source file
+// command line driver, the parser/generator itself is in monolith.h
 
-// syntax restrictions
-// * everything must be in a namespace except main and includes (which must be in global scope)
-// * #define must be one line
-// * no structs/classes etc in other struct/classes
-// * block comment open token must be the first token of the line and close token must be last
-// * includes, field/namespace/struct/class declaration and function prototypes must be one liners, one exception: 
-//   function prototypes can span more lines but breaks must occur after coma that separates params
-//   that includes initializer lists (coma separates fields inits)
-// * {} for functions, structs, enum classes and namespaces must be on separate lines
-// * function body must start on the new line (i.e. '{' that starts a function must be first non-space char of the line right after prototype)
-// * line comments will be trimmed, line comment is the first occurence of // in a line, dont put any // inside of a string
-// * structs can have only fields and methods (no other structs)
-// * no old school enums, enum class only
-// * dont put block comments in funny places e.g. between prototype and '{'
-// * using statements/typedefs only in namespaces
-// * pure virtual methods must be one line
-// * no structs/classes with the same name e.g. ns1::S1 and ns2::S1
-// * for now, templates only for classes
-// * DON'T put 'struct::' with a struct member e.g. struct S{ int S::fun(){return 0;} };
-
-#include <fstream>
-#include <vector>
-#include <string>
-#include <cstdio>
-#include <iostream>
-#include <stdexcept>
-#include <functional>
-#include <algorithm>
-#include <sstream>
-#include <regex>
-#include <type_traits>
-#include <unordered_map>
+#include "monolith.h"
 
 using std::vector;
 using std::string;
 
-namespace util
+#ifdef MONOLITH_FUZZ
+// libFuzzer target, build: clang++ -std=c++17 -g -O1 -fsanitize=fuzzer,address -DMONOLITH_FUZZ main.cpp
+// differential check: input parsed from memory with std::getline (reference) and streamed through LineReader
+// must give the same header or the same error, source must have the same declarations in the same namespaces
+// (streamed bodies come first)
+// syntax errors are expected, any other exception or mismatch is a crash
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
 {
-    struct Match
-    {
-        int position;
-        string str;
-    };
+    string content((const char*)data, size);
 
-    bool startsWith(const string& s, const string& start)
-    {
-        return s.find(start) == 0;
-    }
-
-    template <typename T>
-    T firstOrDefault(const vector<T>& v, std::function<bool(T)> pred)
-    {
-        for (int i = 0; i < v.size(); i++)
-            if (pred(v.at(i)))
-                return v.at(i);
+    // '\0' ends a segment in LineReader, fmemopen needs size > 0
+    if (size == 0 || content.find('\0') != string::npos)
+        return 0;
 
-        if (std::is_pointer<T>::value)
-            return nullptr;
-        else
-            return T();
-    }
+    string header, source, error;
 
-    template <typename K, typename V>
-    bool contains(const std::unordered_map<K, V>& umap, const K& key)
+    try
     {
-        try
-        {
-            auto& val = umap.at(key);
-            return true;
-        }
-        catch (std::out_of_range&)
-        {
-            return false;
-        }
+        monolith::Output output = monolith::Generate({ { "<stdin>", content } }, monolith::Options());
+        header = output.header;
+        source = output.sources.at(0);
     }
-
-    // returns first match of 'regex' in s
-    // if there is no match, it returns (-1, "")
-    Match firstMatch(const string& s, const string& regex)
+    catch (std::runtime_error& e)
     {
-        std::smatch result;
-        std::regex r(regex);
-
-        std::regex_search(s, result, r);
-
-        if (result.size() == 0)
-            return{ -1, "" };
-        else
-            return{ result.position(0), result[0] };
+        error = e.what();
     }
 
-    void syntaxError(int line, const string& filename, const char* msg)
-    {
-        std::stringstream str;
-        str << "Syntax error " << filename << ":" << line;
-        if (msg != 0)
-            str << " " << msg;
+    std::ostringstream streamedHeader, streamedSource;
+    string streamedError;
+    FILE* file = fmemopen((void*)data, size, "rb");
 
-        throw std::runtime_error(str.str().c_str());
-    }
-
-    string trim(const string& str)
+    try
     {
-        if (str.length() == 0)
-            return str;
-
-        string newstr(str);
-
-        if (newstr.size() != str.size())
-            throw std::runtime_error("crow says FUCK YOU");
-
-        while (newstr.size() > 0 && newstr.back() == ' ')
-            newstr.pop_back();
-
-        int start;
-        for (start = 0; start < (int)newstr.length() && str.at(start) == ' '; start++)
-        {
-        }
-
-        return newstr.substr(start);
+        monolith::Monolith mono(file, false, monolith::Options(), streamedSource);
+        mono.Dump(streamedHeader, streamedSource, "");
     }
-
-    string removeLineComment(const string& s)
+    catch (std::runtime_error& e)
     {
-        auto comment = util::firstMatch(s, "\\s*//");
-
-        if (comment.position == -1)
-            return s;
-
-        return s.substr(0, comment.position);
+        streamedError = e.what();
     }
 
-    bool endsWith(const string& s, const string& end)
-    {
-        if (s.length() < end.length())
-            return false;
-
-        return s.rfind(end) == (s.length() - end.length());
-    }
+    fclose(file);
 
-    bool IsMethodProto(const string& str)
+    if (error != streamedError)
     {
-        return (str.back() == ')' || util::endsWith(str, "const") || util::endsWith(str, "override"));
+        fprintf(stderr, "error mismatch\n%s\n%s\n", error.c_str(), streamedError.c_str());
+        abort();
     }
-}
 
-namespace monolith
-{
-    enum class AccessSpecifier
-    {
-        Private, Public, NoSpecifier, Protected
-    };
+    if (error.length() != 0)
+        return 0;
 
-    class IDump
+    // namespace blocks depend on order of declarations which is not the same, so source is compared
+    // as sorted declarations each with namespace block it is in, declarations end with empty line
+    // braces are counted like the parser counts them in bodies, false if they do not balance or a block is left open
+    auto declarations = [](const string& text, vector<string>& decls)
     {
-    public:
-        virtual void Dump(std::ostream& header, std::ostream& source) = 0;
+        std::istringstream stream(text);
+        string line, block, decl;
+        int depth = 0; // 1 is inside namespace block
 
-        virtual const string& GetProto()
+        while (std::getline(stream, line))
         {
-            throw std::runtime_error("GetProto() used without override");
-        };
-    };
+            bool blockEnd = depth == 1 && block.length() != 0 && line == "}";
 
-    class BaseFunc
-    {
-    protected:
-        std::string body;
-        std::string _namespace;
-        std::string prototype;
-    public:
-        BaseFunc(const string& ns)
-            : _namespace(ns)
-        {
-        }
-
-        void AddProto(const string& s)
-        {
-            prototype += s;
-        }
-
-        void AddBody(const string& s)
-        {
-            body += s;
-        }
-
-        // where name starts
-        // this method assumes that name is right before first '('
-        int GetNameIndex(const string& proto)
-        {
-            // find first '('
-            int index = proto.find('(');
-            // find id
-            auto id = util::firstMatch(proto, "([~_a-zA-Z0-9]+\\s*\\()|( operator[^_a-zA-Z0-9])");
-
-            if (util::startsWith(id.str, " operator"))
-                return id.position + 1;
-
-            if (id.position == -1)
+            if ((depth == 0 && util::startsWith(line, "namespace ")) || blockEnd || (line.length() == 0 && depth == (block.length() != 0 ? 1 : 0)))
             {
-                string msg = "BaseFunc::nameIndex() no id found before '(' in " + prototype;
-                throw std::runtime_error(msg.c_str());
-            }
-
-            return id.position;
-        }
-    };
-
-    class Method : public IDump, public BaseFunc
-    {
-    private:
-        std::string initializerList;
-        string structName;
-    public:
-        Method(const string& ns, const string& _struct) 
-            :BaseFunc(ns), structName(_struct)
-        {
-        }
-
-        // separate prototype from initializer list
-        void SplitProto()
-        {
-            int openparencounter = 0;
+                if (decl.length() != 0)
+                    decls.push_back(block + "\n" + decl);
 
-            // for loop looks for a single ':' (not ::) thats outside of any parenthases
-            for(int i=0;i<(int)prototype.size();i++)
-            {
-                if (prototype.at(i) == '(')
-                    openparencounter++;
-                else if (prototype.at(i) == ')')
-                    openparencounter--;
+                decl.clear();
 
-                if (prototype.at(i) == ':' && openparencounter == 0 && prototype.at(i + 1) != ':')
+                if (line.length() != 0)
                 {
-                    initializerList = prototype.substr(i);
-                    prototype = prototype.substr(0, i);
-                    break;
+                    block = blockEnd ? "" : line;
+                    depth = blockEnd ? 0 : 1;
                 }
-                else if (prototype.at(i) == ':' && prototype.at(i + 1) == ':') // skipp ::
-                    i++;
-            }
 
-            prototype = util::trim(prototype);
-        }
-
-        const string& GetProto() override
-        {
-            return prototype;
-        }
-
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            // prototype in header
-            header << prototype << ';' << std::endl;
-            header << std::endl;
-
-            // implementation in source
-            // insert namespace
-            string implProto(prototype);
-
-            // remove override from impl
-            int overridePos = implProto.find("override");
-            if (overridePos != string::npos)
-                implProto = implProto.replace(overridePos, 8, "");
+                continue;
+            }
 
-            // remove static from impl
-            if (util::startsWith(implProto,"static "))
-                implProto = implProto.replace(0, 7, "");
-            
-            implProto.insert(GetNameIndex(implProto), structName + "::");
+            decl += line + "\n";
+            depth += (int)std::count(line.begin(), line.end(), '{') - (int)std::count(line.begin(), line.end(), '}');
 
-            source << "namespace " << _namespace << "{" << std::endl;
-            source << implProto << initializerList << std::endl;
-            source << body << "}" << std::endl;
-            source << std::endl;
+            if (depth < (block.length() != 0 ? 1 : 0))
+                return false;
         }
-    };
 
-    class Function : public BaseFunc, public IDump
-    {
-    public:
-        Function(const string& ns)
-            :BaseFunc(ns)
-        {
-        }
+        if (decl.length() != 0)
+            decls.push_back(block + "\n" + decl);
 
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            // main
-            if (util::startsWith(prototype, "int main("))
-            {
-                source << prototype << std::endl;
-                source << body << std::endl;
-                source << std::endl;
-            }
-            else
-            {
-                // prototype in header
-                header << "namespace " << _namespace << " {" << std::endl;
-                header << prototype << ";}" << std::endl;
-                header << std::endl;
-                
-                source << "namespace " << _namespace << " {" << std::endl;
-                source << prototype << std::endl;
-                source << body << "}" << std::endl;
-                source << std::endl;
-            }
-        }
+        std::sort(decls.begin(), decls.end());
+        return depth == 0;
     };
 
-    // struct member
-    class Field : public IDump
+    // body whose last line closes more than its own brace e.g. '}}' leaves nothing to count on,
+    // then only the lines are compared
+    auto lines = [](const string& text)
     {
-    private:
-        std::string prototype;
-    public:
-        Field(const string& proto):
-            prototype(proto)
-        {
-        }
+        vector<string> v;
+        std::istringstream stream(text);
+        string line;
 
-        const string& GetProto() override
-        {
-            return prototype;
-        }
+        while (std::getline(stream, line))
+            if (line != "}" && !util::startsWith(line, "namespace "))
+                v.push_back(line);
 
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            header << prototype << std::endl;
-        }
+        std::sort(v.begin(), v.end());
+        return v;
     };
 
-    // the difference between variable and nsvariable is that ns variable needs to dump extern in header
-    // ns member
-    class NsVariable : public IDump
-    {
-    private:
-        string prototype;
-        string _namespace;
-        string value; // in case of initialized variables
+    vector<string> decls, streamedDecls;
+    bool balanced = declarations(source, decls);
+    bool sameSource = balanced ? declarations(streamedSource.str(), streamedDecls) && decls == streamedDecls : lines(source) == lines(streamedSource.str());
 
-        // splits decl and init if there is '='
-        void SplitDeclaration()
-        {
-            int equalpos = prototype.find('=');
-
-            if (equalpos == string::npos)
-                return;
-
-            value = prototype.substr(equalpos + 1);
-            prototype = prototype.substr(0, equalpos);
-        }
-    public:
-        NsVariable(const string& proto, const string& ns):
-            prototype(proto), _namespace(ns)
-        {
-            SplitDeclaration();
-        }
-
-        int GetNameIndex() const
-        {
-            auto name = util::firstMatch(prototype, "[_a-z0-9A-Z]+;");
-            return name.position;
-        }
-
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            header << "namespace " << _namespace << " {" << std::endl;
-            header << "    extern " << prototype;
-
-            if (value.length() != 0)
-                header << ";";
-
-            header << "}" << std::endl;
-            header << std::endl;
-
-            source << "namespace " << _namespace << " {" << std::endl;
-            source << prototype;
-
-            if (value.length() != 0)
-                source << '=' << value;
-
-            source << "}" << std::endl;
-            source << std::endl;
-        }
-    };
-
-    class EnumClass : public IDump
+    if (header != streamedHeader.str() || !sameSource)
     {
-    private:
-        string prototype;
-        string name;
-        string body;
-        string _namespace;
-    public:
-        EnumClass(string proto, const string& ns):
-            prototype(proto), _namespace(ns)
-        {
-            int whereNameStarts = string("enum class ").length();
-            string protostartingwithname(prototype.substr(whereNameStarts));
-
-            auto match = util::firstMatch(protostartingwithname, "[_a-zA-Z0-9]+");
-            name = match.str;
-        }
-
-        void AddBody(const string& str)
-        {
-            body += str;
-        }
-
-        // simple prototype is just enum class + name (no specifier part)
-        string GetSimplePrototype() const
-        {
-            return "enum class " + name;
-        }
+        fprintf(stderr, "output mismatch\n");
+        abort();
+    }
 
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            header << "namespace " << _namespace << std::endl;
-            header << "{" << std::endl;
-            header << prototype << std::endl;
-            header << body << std::endl;
-            header << "}" << std::endl;
-            header << std::endl;
-        }
-    };
+    return 0;
+}
+#else
+int main(int argc, char** argv)
+{
+    vector<string> args;
+    for (int i = 1; i < argc; i++)
+        args.push_back(argv[i]);
 
-    class Using : public IDump
+    try
     {
-    private:
-        string prototype;
-        string _namespace;
-    public:
-        Using(const string& proto, const string& ns) 
-            :prototype(proto), _namespace(ns)
-        {
-        }
-
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            header << "namespace " << _namespace << "{" << std::endl;
-            header << "    " <<prototype << "}" << std::endl;
-            header << std::endl;
-        }
-    };
-
-    /*enum class SCType
+        args = util::expandResponseFiles(args);
+    }
+    catch (std::exception& e)
     {
-        Struct, Class
-    };*/
+        printf("%s\n", e.what());
+        exit(0);
+    }
 
-    enum class NodeColor
-    {
-        White, Gray, Black
-    };
+    string headerFile;
+    string sourceFile;
+    string manifestFile; // hashes of declarations for change detection
+    string diffFile; // manifest of previous run
+    bool stats = false; // print output size reduction
+    vector<string> files;
+    vector<monolith::Variant> variants; // more flag sets in one run
+    monolith::Options options;
 
-    class StructClass : public IDump
+    try
     {
-    protected:
-        string _template;
-        string prototype;
-        string name;
-        string _namespace;
-        vector<IDump*> members; // outside private/public
-        vector<IDump*> privateMembers;
-        vector<IDump*> publicMembers;
-        vector<IDump*> protectedMembers;
-
-        NodeColor color;
-        vector<StructClass*> dependencies;
-
-        void FindDependenciesIn(const std::unordered_map<string, StructClass*>& structClasses, vector<IDump*>& v)
+        for (int i = 0; i < (int)args.size(); i++)
         {
-            for (IDump* i : v)
+            if (args.at(i) == "-s")
             {
-                string proto = i->GetProto();
-
-                // fields, actually only fields have to be resolved
-                if (proto.back() == ';')
-                {
-                    // get rid off identifier
-                    {
-                        auto id = util::firstMatch(proto, "[_a-zA-Z0-9]+;");
-
-                        if (id.position == -1)
-                        {
-                            string msg = "FindDependencies() could not find id of a variable: [" + proto + "] in struct " + _namespace + "::" + name;
-                            throw std::runtime_error(msg.c_str());
-                        }
-
-                        proto = proto.substr(0, id.position);
-                    }
-
-                    // search all ids without * or & at the end then check the hashtable for dependencies
-                    util::Match m;
-
-                    while ((m = util::firstMatch(proto, "([_a-zA-Z0-9]+::)*([_a-zA-Z0-9]+)( )*[&\\*]?")).position != -1)
-                    {
-                        // remove result
-                        proto = proto.replace(m.position, m.str.length(), "");
-                        m.str = util::trim(m.str);
-
-                        // is followed by * or &
-                        if (m.str.back() == '*' || m.str.back() == '&')
-                            continue;
-
-                        auto it = structClasses.find(m.str);
-
-                        if (it != structClasses.end())
-                            dependencies.push_back(it->second);
-                    }
-                }
-                // methods, no need :D
-                /*else if (util::IsMethodProto(proto))
-                {
-                }*/
-
+                sourceFile = args.at(i + 1);
+                options.sourceFile = sourceFile;
+                i++;
             }
-        }
-    public:
-        StructClass(const string& proto, const string& ns, const string& templ):
-            prototype(proto), _namespace(ns), color(NodeColor::White), _template(templ)
-        {
-            auto match = util::firstMatch(prototype, " [_a-zA-Z0-9]+");
-            name = match.str.substr(1); // substr(1) because it starts with space
-        }
-
-        const string& GetName() const
-        {
-            return name;
-        }
-
-        // to find dependencies find all words that dont end with & or * and that ar not identifiers or keywords
-        // example: s id1;  ->   dependends on s
-        //          s* id2; ->   no dependency
-        //          struct S : public S2 -> depends on S2
-        //          void   fun1(const s& _s1, Fish f); -> depends on Fish
-        void FindDependencies(const std::unordered_map<string, StructClass*>& structClasses)
-        {
-            int colonPos = prototype.find(':');            
-
-            // find inheritance dependencies
-            if (colonPos != string::npos)
+            else if (args.at(i) == "-h")
             {
-                string str = prototype.substr(colonPos);
-                util::Match m;
-
-                while ((m = util::firstMatch(str, "[_a-zA-Z0-9]+")).position != -1)
-                {
-                    str = str.substr(m.position + m.str.length());
-                    auto it = structClasses.find(m.str);
-
-                    if (it != structClasses.end())
-                        dependencies.push_back(it->second);
-                }
+                headerFile = args.at(i + 1);
+                i++;
             }
-
-            FindDependenciesIn(structClasses, members);
-            FindDependenciesIn(structClasses, privateMembers);
-            FindDependenciesIn(structClasses, protectedMembers);
-            FindDependenciesIn(structClasses, publicMembers);
-        }
-
-        void Traverse(const std::unordered_map<string, StructClass*>& structClasses, vector<StructClass*>& ordered)
-        {
-            if (color == NodeColor::Gray)
-                throw std::runtime_error("dependency loop detected");
-            else if (color == NodeColor::Black)
-                return;
-
-            color = NodeColor::Gray;
-
-            for (auto& e : dependencies)
-                e->Traverse(structClasses, ordered);
-
-            color = NodeColor::Black;
-            ordered.push_back(this);
-        }
-
-        // return struct or class
-        /*SCType GetType() const
-        {
-            if (util::startsWith(prototype, "struct"))
-                return SCType::Struct;
-            else
-                return SCType::Class;
-        }*/
-
-        // simple prototype is just class/struct + name (no inheritance part)
-        string GetSimplePrototype() const
-        {
-            if (util::startsWith(prototype, "class"))
-                return "class " + name;
-            else if (util::startsWith(prototype, "struct"))
-                return "struct " + name;
-            else
-                return "union " + name;
-        }
-
-        void AddMember(IDump* m, AccessSpecifier acc)
-        {
-            if (acc == AccessSpecifier::NoSpecifier)
-                members.push_back(m);
-            else if (acc == AccessSpecifier::Private)
-                privateMembers.push_back(m);
-            else if (acc == AccessSpecifier::Protected)
-                protectedMembers.push_back(m);
-            else if (acc == AccessSpecifier::Public)
-                publicMembers.push_back(m);
-        }
-
-        void DumpForwardDecl(std::ostream& header)
-        {
-            header << "namespace " << _namespace << " {" << std::endl;
-            header << GetSimplePrototype() << ";}" << std::endl;
-            header << std::endl;
-        }
-
-        void Dump(std::ostream& header, std::ostream& source) override
-        {
-            header << "namespace " << _namespace << " {" << std::endl;
-            
-            if(_template.length() != 0)
-                header << _template << std::endl;
-
-            header << prototype << std::endl;
-            header << '{' << std::endl;
-            
-            for (IDump* m : members)
-                m->Dump(header, source);
-
-            if (privateMembers.size() > 0)
+            else if (args.at(i) == "-f")
             {
-                header << "private:" << std::endl;
+                options.flags.push_back(args.at(i + 1));
+                i++;
             }
-
-            for (IDump* m : privateMembers)
-                m->Dump(header, source);
-
-            if (protectedMembers.size() > 0)
+            else if (args.at(i) == "-hname")
             {
-                header << "protected:" << std::endl;
+                options.hfile = args.at(i + 1);
+                i++;
             }
-
-            for (IDump* m : protectedMembers)
-                m->Dump(header, source);
-
-            if (publicMembers.size() > 0)
+            else if (args.at(i) == "-line")
             {
-                header << "public:" << std::endl;
+                options.lineDirectives = true;
             }
-
-            for (IDump* m : publicMembers)
-                m->Dump(header, source);
-
-            header << "};}" << std::endl << std::endl;
-        }
-    };
-
-    class Monolith
-    {
-    private:        
-        vector<string> includes;
-        vector<string> flags; // for conditional file parsing
-        std::unordered_map<string,StructClass*> structClasses;
-        vector<Function*> functions;
-        vector<NsVariable*> variables;
-        vector<EnumClass*> enums;
-        vector<Using*> usings;
-        Function* main;
-        vector<StructClass*> orderedStructClasses;
-        
-        int lineNum;
-        string filename; // currently parsed file, used to error messages
-        std::function<bool(string&)> next;  // read next source code line to the string, return true if eof
-        string currentNamespace;
-
-        //////////////////////////
-        //// PARSER FUNCTIONS ////
-        //////////////////////////
-
-        void enterNamespace(const string& str)
-        {
-            if (currentNamespace.length() > 0)
-                currentNamespace += "::";
-
-            currentNamespace += str;
-        }
-
-        void exitNamespace()
-        {
-            while (currentNamespace.length() > 0 && currentNamespace.back() != ':')
-                currentNamespace.pop_back();
-
-            if (currentNamespace.length() > 0)
+            else if (args.at(i) == "-stats")
             {
-                currentNamespace.pop_back();
-                currentNamespace.pop_back();
+                stats = true;
             }
-        }
-        
-        Function* ExtractFunction(string& line)
-        {
-            Function* fun = new Function(currentNamespace);
-
-            // get prototype first
-            fun->AddProto(line);
-            next(line);
-            line = util::removeLineComment(line);
-
-            // prototype goes until line == '{'
-            while(line != "{")
+            else if (args.at(i) == "-j")
             {
-                fun->AddProto(line);
-                if (next(line))
-                    util::syntaxError(lineNum, filename, "unexpected EOF");
-                line = util::removeLineComment(line);
+                options.threads = std::stoi(args.at(i + 1));
+                i++;
             }
-
-            // start counting braces
-            // fun body will end when matching '}' encountered
-            int openBrace = 1;
-
-            // get body
-            fun->AddBody(line);
-            fun->AddBody("\n");
-
-            do
-            {
-                if (next(line))
-                    util::syntaxError(lineNum, filename, "unexpected EOF");
-
-                fun->AddBody(line);
-                fun->AddBody("\n");
-
-                openBrace += std::count(line.begin(), line.end(), '{');
-                openBrace -= std::count(line.begin(), line.end(), '}');
-            } while (openBrace > 0); // keep going until matching closing brace
-
-            return fun;
-        }
-
-        Method* ExtractMethod(string& line, const string& structName)
-        {
-            Method* method = new Method(currentNamespace, structName);
-
-            // get prototype first
-            method->AddProto(line);
-            next(line);
-            line = util::removeLineComment(line);
-
-            // prototype goes until line == '{'
-            while (line != "{")
+            else if (args.at(i) == "-profile")
             {
-                method->AddProto(line);
-                if (next(line))
-                    util::syntaxError(lineNum, filename, "unexpected EOF");
-                line = util::removeLineComment(line);
+                options.profile = args.at(i + 1);
+                i++;
             }
-            
-            method->SplitProto();
-
-            // start counting braces
-            // fun body will end when matching '}' encountered
-            int openBrace = 1;
-
-            // get body
-            method->AddBody(line);
-            method->AddBody("\n");
-
-            do
+            else if (args.at(i) == "-manifest")
             {
-                if (next(line))
-                    util::syntaxError(lineNum, filename, "unexpected EOF");
-
-                method->AddBody(line);
-                method->AddBody("\n");
-
-                openBrace += std::count(line.begin(), line.end(), '{');
-                openBrace -= std::count(line.begin(), line.end(), '}');
-            } while (openBrace > 0); // keep going until matching closing brace
-
-            return method;
-        }
-
-        EnumClass* ExtractEnumClass(const string& prototype)
-        {
-            EnumClass* enumClass = new EnumClass(prototype, currentNamespace);
-
-            string line;
-
-            // next line must be '{'
-            next(line);
-            line = util::removeLineComment(line);
-
-            if (line != "{")
-                util::syntaxError(lineNum, filename, "missing '{'");
-
-            enumClass->AddBody(line);
-
-            while (true)
+                manifestFile = args.at(i + 1);
+                i++;
+            }
+            else if (args.at(i) == "-variant")
             {
-                next(line);
-
-                if (util::startsWith(line, "/*"))
-                {
-                    while (!util::endsWith(line, "*/"))
-                        next(line);
-                }
+                monolith::Variant variant;
+                variant.name = args.at(i + 1);
+                std::istringstream flags(args.at(i + 2));
+                string flag;
 
-                line = util::removeLineComment(line);
-                enumClass->AddBody(line);
+                while (std::getline(flags, flag, ','))
+                    if (flag.length() != 0)
+                        variant.flags.push_back(flag);
 
-                if (line == "};")
-                    break;
+                variants.push_back(variant);
+                i += 2;
             }
-
-            return enumClass;
-        }
-
-        StructClass* ExtractStructClass(const string& prototype, const string& templ)
-        {
-            StructClass* structClass = new StructClass(prototype, currentNamespace, templ);
-            string line;
-            AccessSpecifier accSpecifier = AccessSpecifier::NoSpecifier;
-
-            // next line must be '{'
-            next(line);
-            line = util::removeLineComment(line);
-
-            if (line != "{")
-                util::syntaxError(lineNum, filename, "missing '{'");
-
-            while (true)
+            else if (args.at(i) == "--diff-against")
             {
-                next(line);
-                line = util::removeLineComment(line);
-
-                if (line == "private:")
-                    accSpecifier = AccessSpecifier::Private;
-                else if (line == "public:")
-                    accSpecifier = AccessSpecifier::Public;
-                else if (line == "protected:")
-                    accSpecifier = AccessSpecifier::Protected;
-                else if (line == "};")
-                    break;
-                else if (util::startsWith(line, "/*"))
-                {
-                    while (!util::endsWith(line, "*/"))
-                        next(line);
-                }       
-                else if (util::endsWith(line, ";"))
-                {
-                    Field* field = new Field(line);
-                    structClass->AddMember(field, accSpecifier);
-                }
-                else if (util::endsWith(line, ")") || util::endsWith(line, ",") || util::endsWith(line, "const") || util::endsWith(line, "override"))
-                {
-                    Method* m = ExtractMethod(line, structClass->GetName());
-                    structClass->AddMember(m, accSpecifier);
-                }
-                else if (line.length() == 0)
-                {
-                }
-                else
-                    util::syntaxError(lineNum, filename, "unknown struct member");
+                diffFile = args.at(i + 1);
+                i++;
             }
+            else
+                files.push_back(args.at(i));
+        }        
+    }
+    catch (std::exception&)
+    {
+        printf("problem with cmd line args\n");
+        exit(0);
+    }
 
-            return structClass;
-        }
-
-        void ExtractNamespace(string& line)
-        {
-            enterNamespace(line.substr(10));
-            string templ;
-
-            // match '{'
-            next(line);
-
-            if (line != "{")
-                util::syntaxError(lineNum, filename, "{ expected");
-
-            while (true)
-            {
-                next(line);
-                line = util::removeLineComment(line);
-                templ = "";
-
-                if (util::startsWith(line, "using") || util::startsWith(line, "typedef"))
-                {
-                    Using* u = new Using(line, currentNamespace);
-                    usings.push_back(u);
-                }
-                else if (util::startsWith(line, "template"))
-                {
-                    templ = line;
-                }
-                else if (util::startsWith(line, "/*"))
-                {
-                    while (!util::endsWith(line, "*/"))
-                        next(line);
-                }
-                else if (util::endsWith(line, ";"))
-                {
-                    NsVariable* var = new NsVariable(line, currentNamespace);
-                    variables.push_back(var);
-                }
-                else if (util::endsWith(line, ")") || util::endsWith(line, ","))
-                {
-                    Function* fun = ExtractFunction(line);
-                    functions.push_back(fun);
-                }
-                else if (util::startsWith(line, "enum class"))
-                {                    
-                    EnumClass* e = ExtractEnumClass(line);
-                    enums.push_back(e);
-                }
-                else if (util::startsWith(line, "class") || util::startsWith(line, "struct") || util::startsWith(line, "union"))
-                {
-                    StructClass* s = ExtractStructClass(line, templ);
-
-                    // structs with the same name are not allowed
-                    if(util::contains<string,StructClass*>(structClasses, s->GetName()))
-                        throw std::runtime_error("structs with the same name are not allowed");
+    // directories and globs
+    try
+    {
+        files = util::expandInputs(files);
+    }
+    catch (std::exception& e)
+    {
+        printf("%s\n", e.what());
+        exit(0);
+    }
 
-                    structClasses[s->GetName()] = (s);
-                }
-                else if (line.length() == 0)
-                {
-                }
-                else if (util::startsWith(line, "namespace"))
-                {
-                    ExtractNamespace(line);
-                }
-                else if (line == "}")
-                {
-                    break;
-                }
-                else
-                {
-                    util::syntaxError(lineNum, filename, "unknown namespace element");
-                }
-            }
+    if (files.size() == 0)
+    {
+        printf("no source files\n");
+        exit(0);
+    }
 
-            exitNamespace();
+    // one parse, outputs 'out.name.h' and 'out.name.cpp' for every variant
+    if (variants.size() != 0)
+    {
+        // variants are rendered without keeping their IR
+        if (manifestFile.length() != 0 || diffFile.length() != 0 || stats)
+        {
+            printf("-manifest, --diff-against and -stats cannot be used with -variant\n");
+            exit(0);
         }
 
-        // parser entry point
-        void Program()
+        try
         {
-            string line;
+            vector<monolith::InputFile> inputs;
 
-            while (!next(line))
+            for (const string& f : files)
             {
-                line = util::removeLineComment(line);
+                if (f == "-" || f == "-0")
+                    throw std::runtime_error("stdin cannot be used with -variant");
 
-                if (util::startsWith(line, "#include"))
-                {
-                    for (const string& s : includes)
-                        if (s == line)
-                            continue;
+                std::ifstream file(f, std::ios::binary);
 
-                    includes.push_back(line);
-                }
-                else if (util::startsWith(line, "#pragma comment") || util::startsWith(line, "#define"))
-                {
-                    includes.push_back(line);
-                }
-                else if (util::startsWith(line, "#pragma compileif"))
-                {
-                    if (lineNum != 1)
-                        throw std::runtime_error("#pragma compileif must be on the first line");
-                    else
-                    {
-                        string flag = line.substr(18);
-                        bool flagdefined = false;
-                        for (int i = 0; i < (int)flags.size(); i++)
-                            if (flags.at(i) == flag)
-                                flagdefined = true;
+                if (!file.is_open())
+                    throw std::runtime_error(("could not open " + f).c_str());
 
-                        if (!flagdefined)
-                            return;
-                    }
-                }
-                else if (util::startsWith(line, "/*"))
-                {
-                    while (!util::endsWith(line, "*/"))
-                        next(line);
-                }
-                else if (line.length() == 0)
-                {
-                }
-                else if (util::startsWith(line, "namespace"))
-                {
-                    ExtractNamespace(line);
-                }
-                else if (util::startsWith(line,"int main("))
-                {
-                    main = ExtractFunction(line);
-                }
-                else
-                {
-                    util::syntaxError(lineNum, filename, "unknown program element");
-                }
+                std::ostringstream content;
+                content << file.rdbuf();
+                inputs.push_back({ f, content.str() });
             }
-            // dont put any code here
-        }
-
-        /////////////////// parser functions end
-
-        void Collect(const string& filename)
-        {
-            this->filename = filename;
-            this->lineNum = 0;
-            std::ifstream file(filename);
 
-            if (!file.is_open())
-                throw std::runtime_error(("could not open " + filename).c_str());
+            vector<monolith::Output> outputs = monolith::GenerateVariants(inputs, variants, options);
 
-            next = [this, &file](string& str)
+            for (size_t i = 0; i < variants.size(); i++)
             {
-                std::getline(file, str);
-                lineNum++;
-
-                str = util::trim(str);
-
-                return file.eof();
-            };
-            string line;
-
-            Program();
-
-            file.close();
-        }
-
-        void DependencyOrder()
-        {
-            // 1. find dependencies
-            for (auto& sc : structClasses)
-                sc.second->FindDependencies(structClasses);
-
-            // 2. start all dependencies traversal
-            // if there are no dependencies then just copy to ordered
-            // if there is then do DFS to the bottom and copy on the way back
-            // if there is a cycle then throw exception
-            for (auto& sc : structClasses)
-                sc.second->Traverse(structClasses, orderedStructClasses);
+                std::ofstream header(util::variantFileName(headerFile, variants.at(i).name));
+                std::ofstream source(util::variantFileName(sourceFile, variants.at(i).name));
+                header << outputs.at(i).header;
+                source << outputs.at(i).sources.at(0);
+            }
         }
-    public:
-        // ctor is the main driver, it will produce IR of all C++ source files
-        Monolith(const vector<string>& filenames, const vector<string>& _flags):
-            lineNum(0), flags(_flags), main(nullptr)
+        catch (std::exception& e)
         {
-            for (const string& s : filenames)
-                Collect(s);
-
-            DependencyOrder();
+            printf("%s\n", e.what());
         }
 
-        // output IR
-        void Dump(std::ostream& header, std::ostream& source, const string& hfile)
-        {
-            header << "#pragma once" << std::endl;
-
-            for (string& s : includes)
-                header << s << std::endl;
+        return 0;
+    }
 
-            header << '\n';
-            source << "#include \"" << hfile << "\"" << std::endl;
-            source << std::endl;
-            
-            DumpForwardDeclaration(header);
-            
-            // dump main
-            if(main != nullptr)
-                main->Dump(header, source);
+    // stdin inputs can be big, bodies go to source while parsing
+    bool stream = std::find(files.begin(), files.end(), "-") != files.end() || std::find(files.begin(), files.end(), "-0") != files.end();
 
-            Dump2(header, source);
-        }
+    try
+    {
+        std::ofstream header(headerFile);
+        std::ofstream source(sourceFile);
+        monolith::Monolith mono(files, options, stream ? &source : nullptr);
+        mono.Dump(header, source, options.hfile);
 
-        void DumpForwardDeclaration(std::ostream& header)
-        {
-            for (StructClass* sc : orderedStructClasses)
-                sc->DumpForwardDecl(header);
-        }
+        if (stats)
+            mono.DumpStats(header, { &source }, std::cout);
 
-        void Dump2(std::ostream& header, std::ostream& source)
+        // diff is read before manifest is written so both can be the same file
+        if (diffFile.length() != 0)
         {
-            for (IDump* i : usings)
-                i->Dump(header, source);
-
-            header << std::endl;
+            std::ifstream previous(diffFile);
 
-            for (IDump* i : enums)
-                i->Dump(header, source);
+            if (!previous.is_open())
+                throw std::runtime_error(("could not open " + diffFile).c_str());
 
-            for (IDump* i : orderedStructClasses)
-                i->Dump(header, source);
-
-            for (IDump* i : functions)
-                i->Dump(header, source);
-
-            for (IDump* i : variables)
-                i->Dump(header, source);
+            mono.DumpDiff(previous, std::cout);
         }
-    };
-}
-
-int main(int argc, char** argv)
-{
-    vector<string> args;
-    for (int i = 1; i < argc; i++)
-        args.push_back(argv[i]);
-
-    string headerFile;
-    string sourceFile;
-    string hfile; // what to #include in source file
-    vector<string> files;
-    vector<string> flags;
 
-    try
-    {
-        for (int i = 0; i < (int)args.size(); i++)
+        if (manifestFile.length() != 0)
         {
-            if (args.at(i) == "-s")
-            {
-                sourceFile = args.at(i + 1);
-                i++;
-            }
-            else if (args.at(i) == "-h")
-            {
-                headerFile = args.at(i + 1);
-                i++;
-            }
-            else if (args.at(i) == "-f")
-            {
-                flags.push_back(args.at(i + 1));
-                i++;
-            }
-            else if (args.at(i) == "-hname")
-            {
-                hfile = args.at(i + 1);
-                i++;
-            }
-            else
-                files.push_back(args.at(i));
-        }        
-    }
-    catch (std::runtime_error&)
-    {
-        printf("problem with cmd line args\n");
-        exit(0);
-    }
-
-    if (files.size() == 0)
-    {
-        printf("no source files\n");
-        exit(0);
-    }
-
-    try
-    {
-        monolith::Monolith mono(files, flags);
-        mono.Dump(std::ofstream(headerFile), std::ofstream(sourceFile), hfile);
+            std::ofstream manifest(manifestFile);
+            mono.DumpManifest(manifest);
+        }
         //mono.Dump(std::cout, std::cout, "header.h");
     }
     catch (std::exception& e)
@@ -1175,3 +334,4 @@ int main(int argc, char** argv)
 
     return 0;
 }
+#endif
@@ -0,0 +1,3875 @@
+// Maciej Szakowski
+// it takes C++ source files and produces monolithic header and source file 
+// IR is the intermediate representation of all cpp modules that can be dumped to one monolithic source file
+
+// syntax restrictions
+// * everything must be in a namespace except main and includes (which must be in global scope)
+// * #define must be one line
+// * no structs/classes etc in other struct/classes
+// * block comment open token must be the first token of the line and close token must be last
+// * includes, field/namespace/struct/class declaration and function prototypes must be one liners, one exception: 
+//   function prototypes can span more lines but breaks must occur after coma that separates params
+//   that includes initializer lists (coma separates fields inits)
+// * {} for functions, structs, enum classes and namespaces must be on separate lines
+// * function body must start on the new line (i.e. '{' that starts a function must be first non-space char of the line right after prototype)
+// * line comments will be trimmed, line comment is the first occurence of // in a line, dont put any // inside of a string
+// * structs can have only fields and methods (no other structs)
+// * no old school enums, enum class only
+// * dont put block comments in funny places e.g. between prototype and '{'
+// * using statements/typedefs only in namespaces
+// * pure virtual methods must be one line
+// * no structs/classes with the same name e.g. ns1::S1 and ns2::S1
+// * template line must be one line right before struct/class/function/method, no templates for variables and usings
+// * function templates, constexpr/consteval functions and all methods of template structs are put in header
+// * DON'T put 'struct::' with a struct member e.g. struct S{ int S::fun(){return 0;} };
+// * '#pragma compileif expr' must be the first line, file is skipped unless expr of flags (-f) is true
+//   expr can use '!', '&&', '||' and parentheses e.g. '#pragma compileif WIN && (DEBUG || !FAST)'
+//   with -variant every file is parsed once and each variant gets files whose expr is true for its flags
+
+// annotations (put in the line comment of the annotated line)
+// * @cold on a struct field moves it to a companion struct allocated on first use
+//   the field is then accessed through generated accessor e.g. 'debugName()' instead of 'debugName'
+//   structs with cold fields are move only, cold fields must be one declarator non static fields
+// * '// @soa' line right before struct generates struct of arrays container 'NameSoA' next to the struct
+//   one std::vector per non static field, fields cannot be bool (std::vector<bool>) or @cold
+// * '// @reflect' line right before struct or enum class generates constexpr reflect::Reflect<T> specialization
+//   struct: field names, member pointers and offsets (offsetof, standard layout only), @cold fields are skipped
+//   enum class: enumerator names and values, reflect::Reflect<E>::Index(name) is a minimal perfect hash lookup
+//   generated reflection requires c++17
+// * '// @strings' line right before enum class generates ToString(E) and FromString(std::string_view, E&)
+//   in the namespace of the enum, it implies @reflect
+// * '// @serializable' line right before struct generates Encode(std::string&, const S&) and Decode(const char*&, const char*, S&)
+//   in the namespace of the struct, fields are encoded in native byte order, runs of adjacent trivially copyable fields
+//   are copied with one memcpy, other fields must be std::string, std::vector or other @serializable structs
+//   no @cold or bit fields, pointers are copied as values, struct should be standard layout (offsetof)
+// * '// @profile' line right before function, method or struct (all its methods) puts MONOLITH_PROFILE_SCOPE on the line of '{'
+//   Options::profile (-profile regex) does the same for functions/methods whose qualified name matches
+//   scopes write to per thread ring buffers, profile::WriteChromeTrace(std::ostream&) exports chrome trace json
+//   constexpr/consteval functions are never profiled, MONOLITH_NO_PROFILE compiles scopes out
+// * '// @pooled' line right before struct generates class specific operator new/delete backed by thread local free list
+//   (pool::Pool<S>), S::PoolStats() returns allocation statistics of the calling thread, struct cannot be over aligned
+
+#pragma once
+
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <regex>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <cctype>
+#include <string_view>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <charconv>
+#include <climits>
+
+namespace util
+{
+    using std::vector;
+    using std::string;
+
+    struct Match
+    {
+        int position;
+        string str;
+    };
+
+    // string_view so literals dont allocate, it is called for every line many times
+    inline bool startsWith(std::string_view s, std::string_view start)
+    {
+        return s.substr(0, start.length()) == start;
+    }
+
+    template <typename T>
+    T firstOrDefault(const vector<T>& v, std::function<bool(T)> pred)
+    {
+        for (int i = 0; i < v.size(); i++)
+            if (pred(v.at(i)))
+                return v.at(i);
+
+        if (std::is_pointer<T>::value)
+            return nullptr;
+        else
+            return T();
+    }
+
+    template <typename K, typename V>
+    bool contains(const std::unordered_map<K, V>& umap, const K& key)
+    {
+        try
+        {
+            auto& val = umap.at(key);
+            return true;
+        }
+        catch (std::out_of_range&)
+        {
+            return false;
+        }
+    }
+
+    // returns first match of 'regex' in s
+    // if there is no match, it returns (-1, "")
+    // compiling is much more expensive than matching so compiled patterns are kept
+    // patterns are literals so cache stays small, thread_local because output is rendered on more threads
+    inline const std::regex& compiledRegex(const string& regex)
+    {
+        thread_local std::unordered_map<string, std::regex> cache;
+
+        auto it = cache.find(regex);
+
+        if (it == cache.end())
+            it = cache.emplace(regex, std::regex(regex)).first;
+
+        return it->second;
+    }
+
+    inline Match firstMatch(const string& s, const string& regex)
+    {
+        std::smatch result;
+
+        std::regex_search(s, result, compiledRegex(regex));
+
+        if (result.size() == 0)
+            return{ -1, "" };
+        else
+            return{ result.position(0), result[0] };
+    }
+
+    inline void syntaxError(int line, const string& filename, const char* msg)
+    {
+        std::stringstream str;
+        str << "Syntax error " << filename << ":" << line;
+        if (msg != 0)
+            str << " " << msg;
+
+        throw std::runtime_error(str.str().c_str());
+    }
+
+    inline string trim(const string& str)
+    {
+        size_t start = str.find_first_not_of(' ');
+
+        if (start == string::npos)
+            return "";
+
+        return str.substr(start, str.find_last_not_of(' ') - start + 1);
+    }
+
+    // trim without a copy so storage of the line is reused
+    inline void trimInPlace(string& str)
+    {
+        size_t end = str.find_last_not_of(' ');
+
+        if (end == string::npos)
+        {
+            str.clear();
+            return;
+        }
+
+        str.erase(end + 1);
+        str.erase(0, str.find_first_not_of(' '));
+    }
+
+    // returns true if line comment of s contains annotation e.g. "@cold"
+    inline bool hasAnnotation(const string& s, const string& annotation)
+    {
+        auto comment = s.find("//");
+
+        if (comment == string::npos)
+            return false;
+
+        return s.find(annotation, comment) != string::npos;
+    }
+
+    // FNV-1a with seed, generated code has the same function (reflect::Hash)
+    // final mix makes low bits depend on the seed, without it 'A' and 'C' have the same hash % 2 for every seed
+    inline uint32_t hash(const string& s, uint32_t seed)
+    {
+        uint32_t h = 2166136261u ^ seed;
+
+        for (char c : s)
+        {
+            h ^= (uint8_t)c;
+            h *= 16777619u;
+        }
+
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+
+        return h;
+    }
+
+    // 64 bit FNV-1a, h is hash of text before s so long text can be hashed in parts
+    inline uint64_t hash64(const string& s, uint64_t h = 14695981039346656037ull)
+    {
+        for (char c : s)
+        {
+            h ^= (uint8_t)c;
+            h *= 1099511628211ull;
+        }
+
+        return h;
+    }
+
+    // order dependent combination of hashes
+    inline uint64_t hashCombine(uint64_t h, uint64_t value)
+    {
+        return h ^ (value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+    }
+
+    // '#line 12 "src/file.cpp"' so compiler errors and profilers point to the original file
+    inline string lineDirective(int line, const string& file)
+    {
+        string escaped;
+
+        for (char c : file)
+        {
+            if (c == '\\' || c == '"')
+                escaped += '\\';
+
+            escaped += c;
+        }
+
+        return "#line " + std::to_string(line) + " \"" + escaped + "\"";
+    }
+
+    // written to source after a mapped body, LineRestorer replaces it with '#line' of the next line of source
+    const char* const restoreLineMarker = "#line __MONOLITH_RESTORE__";
+
+    // counts lines as they go to target, line number of source is known only there because
+    // parts of source are rendered separately (streamed bodies, threads, namespace blocks)
+    class LineRestoreBuf : public std::streambuf
+    {
+    private:
+        std::streambuf* target;
+        string file; // source name for #line
+        int lines; // lines already written to target
+        string pending; // start of line that is not complete yet
+
+        // s ends with '\n'
+        void WriteLine(const char* s, size_t n)
+        {
+            if (std::string_view(s, n - 1) == restoreLineMarker)
+            {
+                string directive = lineDirective(lines + 2, file) + '\n';
+                target->sputn(directive.data(), directive.size());
+            }
+            else
+                target->sputn(s, n);
+
+            lines++;
+        }
+    protected:
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            std::streamsize written = n;
+
+            while (n > 0)
+            {
+                const char* end = traits_type::find(s, n, '\n');
+
+                if (end == nullptr)
+                {
+                    pending.append(s, n);
+                    break;
+                }
+
+                std::streamsize length = end - s + 1;
+
+                if (pending.length() != 0)
+                {
+                    pending.append(s, length);
+                    WriteLine(pending.data(), pending.size());
+                    pending.clear();
+                }
+                else
+                    WriteLine(s, length);
+
+                s += length;
+                n -= length;
+            }
+
+            return written;
+        }
+
+        int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof())
+            {
+                char ch = traits_type::to_char_type(c);
+                xsputn(&ch, 1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        // marker is written at once so flush never splits it
+        int sync() override
+        {
+            target->sputn(pending.data(), pending.size());
+            pending.clear();
+
+            return target->pubsync();
+        }
+    public:
+        LineRestoreBuf(std::streambuf* _target, const string& _file)
+            : target(_target), file(_file), lines(0)
+        {
+        }
+    };
+
+    // stream source is written through when #line directives are on
+    class LineRestorer : public std::ostream
+    {
+    private:
+        LineRestoreBuf buf;
+    public:
+        LineRestorer(std::ostream& target, const string& file)
+            : std::ostream(nullptr), buf(target.rdbuf(), file)
+        {
+            rdbuf(&buf);
+        }
+    };
+
+    // one copy of strings repeated in many nodes (namespaces, struct names), references stay valid while the interner lives
+    class Interner
+    {
+    private:
+        std::unordered_set<string> strings;
+    public:
+        const string& Intern(const string& str)
+        {
+            return *strings.insert(str).first;
+        }
+    };
+
+    // 'namespace X {' block that is open in output stream, consecutive declarations of the same namespace share it
+    struct NamespaceBlock
+    {
+        string name; // empty if no block is open
+        size_t merged = 0; // declarations that did not reopen the block
+        size_t saved = 0; // bytes of 'namespace X {' and '}' lines that were not written
+    };
+
+    // block is kept in the stream (pword) so declarations keep writing to plain std::ostream
+    inline NamespaceBlock& namespaceBlock(std::ostream& out)
+    {
+        static const int index = std::ios_base::xalloc();
+        void*& block = out.pword(index);
+
+        if (block == nullptr)
+        {
+            block = new NamespaceBlock();
+
+            // freed with the stream
+            out.register_callback([](std::ios_base::event e, std::ios_base& stream, int i)
+            {
+                if (e == std::ios_base::erase_event)
+                    delete (NamespaceBlock*)stream.pword(i);
+            }, index);
+        }
+
+        return *(NamespaceBlock*)block;
+    }
+
+    // must be called before anything that is not in a namespace and at the end of output
+    inline void closeNamespace(std::ostream& out)
+    {
+        NamespaceBlock& block = namespaceBlock(out);
+
+        if (block.name.length() != 0)
+        {
+            out << "}" << std::endl;
+            block.name.clear();
+        }
+    }
+
+    // 'namespace ns {' unless ns is already open, block is closed by the next different namespace or closeNamespace()
+    inline void openNamespace(std::ostream& out, const string& ns)
+    {
+        NamespaceBlock& block = namespaceBlock(out);
+
+        if (block.name == ns)
+        {
+            block.merged++;
+            block.saved += ns.length() + 15; // 'namespace ' ' {\n' '}\n'
+            return;
+        }
+
+        closeNamespace(out);
+        out << "namespace " << ns << " {" << std::endl;
+        block.name = ns;
+    }
+
+    // appends part rendered on its own (parallel rendering) as if it was written to out
+    // part started with no open block so its first 'namespace X {' is dropped if X is open in out
+    inline void appendNamespaced(std::ostream& out, std::ostringstream& part)
+    {
+        string text = part.str();
+
+        if (text.length() == 0)
+            return;
+
+        NamespaceBlock& block = namespaceBlock(out);
+        NamespaceBlock& partBlock = namespaceBlock(part);
+        string reopen = "namespace " + block.name + " {\n";
+
+        if (block.name.length() != 0 && startsWith(text, reopen))
+        {
+            out.write(text.data() + reopen.length(), text.length() - reopen.length());
+            block.merged++;
+            block.saved += reopen.length() + 2;
+        }
+        else
+        {
+            closeNamespace(out);
+            out << text;
+        }
+
+        block.name = partBlock.name;
+        block.merged += partBlock.merged;
+        block.saved += partBlock.saved;
+    }
+
+    // manifest line 'kind interfaceHash bodyHash name', hashes are hex
+    inline void dumpManifestLine(std::ostream& manifest, const string& kind, uint64_t interfaceHash, uint64_t bodyHash, const string& name)
+    {
+        char hashes[40];
+        snprintf(hashes, sizeof(hashes), "%016llx %016llx", (unsigned long long)interfaceHash, (unsigned long long)bodyHash);
+
+        manifest << kind << " " << hashes << " " << name << std::endl;
+    }
+
+    struct ManifestEntry
+    {
+        string key; // 'kind name', overloads get '#2', '#3'...
+        uint64_t interfaceHash;
+        uint64_t bodyHash;
+    };
+
+    inline vector<ManifestEntry> readManifest(std::istream& manifest)
+    {
+        vector<ManifestEntry> entries;
+        std::unordered_map<string, int> counts;
+        string line;
+
+        while (std::getline(manifest, line))
+        {
+            if (line.length() == 0)
+                continue;
+
+            std::istringstream fields(line);
+            string kind, name;
+            unsigned long long interfaceHash, bodyHash;
+
+            if (!(fields >> kind >> std::hex >> interfaceHash >> bodyHash) || !std::getline(fields, name))
+                throw std::runtime_error(("bad manifest line " + line).c_str());
+
+            string key = kind + " " + trim(name);
+            int count = ++counts[key];
+
+            if (count > 1)
+                key += "#" + std::to_string(count);
+
+            entries.push_back({ key, interfaceHash, bodyHash });
+        }
+
+        return entries;
+    }
+
+    // minimal perfect hash of keys (hash and displace), keys must be unique
+    // displacements are indexed by hash(key, 0) % n, d < 0 means the key is in slot -d-1
+    // otherwise the key is in slot hash(key, d) % n, slots[slot] is index of the key in keys
+    inline void perfectHash(const vector<string>& keys, vector<int>& displacements, vector<int>& slots)
+    {
+        const uint32_t maxDisplacement = 1 << 20;
+        int n = (int)keys.size();
+        vector<vector<int>> buckets(n);
+        displacements.assign(n, 0);
+        slots.assign(n, -1);
+
+        for (int i = 0; i < n; i++)
+            buckets.at(hash(keys.at(i), 0) % n).push_back(i);
+
+        // biggest buckets first, they are the hardest to place
+        std::sort(buckets.begin(), buckets.end(), [](const vector<int>& a, const vector<int>& b) { return a.size() > b.size(); });
+
+        int b;
+        for (b = 0; b < n && buckets.at(b).size() > 1; b++)
+        {
+            vector<int>& bucket = buckets.at(b);
+            vector<int> taken;
+            uint32_t d = 1;
+
+            // try displacements until all keys of the bucket land in free slots
+            // duplicate keys never do, displacement must also fit in int
+            for (int item = 0; item < (int)bucket.size();)
+            {
+                int slot = hash(keys.at(bucket.at(item)), d) % n;
+
+                if (slots.at(slot) != -1 || std::find(taken.begin(), taken.end(), slot) != taken.end())
+                {
+                    if (d == maxDisplacement)
+                    {
+                        string msg = "perfect hash not found for '" + keys.at(bucket.at(0)) + "', keys must be unique";
+                        throw std::runtime_error(msg.c_str());
+                    }
+
+                    d++;
+                    item = 0;
+                    taken.clear();
+                }
+                else
+                {
+                    taken.push_back(slot);
+                    item++;
+                }
+            }
+
+            displacements.at(hash(keys.at(bucket.at(0)), 0) % n) = (int)d;
+
+            for (int i = 0; i < (int)bucket.size(); i++)
+                slots.at(taken.at(i)) = bucket.at(i);
+        }
+
+        // one key buckets go directly to free slots
+        int freeSlot = 0;
+        for (; b < n && buckets.at(b).size() == 1; b++)
+        {
+            while (slots.at(freeSlot) != -1)
+                freeSlot++;
+
+            int key = buckets.at(b).at(0);
+            displacements.at(hash(keys.at(key), 0) % n) = -freeSlot - 1;
+            slots.at(freeSlot) = key;
+        }
+    }
+
+    // 'reflect' namespace that is put in the header once if anything is reflected
+    // Hash must be the same as util::hash
+    inline void dumpReflectPreamble(std::ostream& header)
+    {
+        header << "namespace reflect {" << std::endl;
+        header << "template <typename T> struct Reflect;" << std::endl;
+        header << "constexpr std::uint32_t Hash(std::string_view s, std::uint32_t seed)" << std::endl;
+        header << "{" << std::endl;
+        header << "std::uint32_t h = 2166136261u ^ seed;" << std::endl;
+        header << "for (char c : s) { h ^= (std::uint8_t)c; h *= 16777619u; }" << std::endl;
+        header << "h ^= h >> 16; h *= 0x85ebca6bu; h ^= h >> 13;" << std::endl;
+        header << "return h;" << std::endl;
+        header << "}}" << std::endl;
+        header << std::endl;
+    }
+
+    // 'serial' namespace that is put in the header once if anything is @serializable
+    // generic Encode/Decode for trivially copyable types, std::string and std::vector
+    // RunStart/RunBytes find runs of adjacent trivially copyable fields in generated layouts
+    inline void dumpSerialPreamble(std::ostream& header)
+    {
+        header << "namespace serial {" << std::endl;
+        header << "template <typename T>" << std::endl;
+        header << "typename std::enable_if<std::is_trivially_copyable<T>::value>::type Encode(std::string& out, const T& v) { out.append((const char*)&v, sizeof(T)); }" << std::endl;
+        header << "template <typename T>" << std::endl;
+        header << "typename std::enable_if<std::is_trivially_copyable<T>::value, bool>::type Decode(const char*& in, const char* end, T& v)" << std::endl;
+        header << "{" << std::endl;
+        header << "if ((std::size_t)(end - in) < sizeof(T)) return false;" << std::endl;
+        header << "std::memcpy(&v, in, sizeof(T)); in += sizeof(T); return true;" << std::endl;
+        header << "}" << std::endl;
+        header << "inline void Encode(std::string& out, const std::string& v) { Encode(out, (std::uint32_t)v.size()); out.append(v); }" << std::endl;
+        header << "inline bool Decode(const char*& in, const char* end, std::string& v)" << std::endl;
+        header << "{" << std::endl;
+        header << "std::uint32_t n;" << std::endl;
+        header << "if (!Decode(in, end, n) || (std::size_t)(end - in) < n) return false;" << std::endl;
+        header << "v.assign(in, n); in += n; return true;" << std::endl;
+        header << "}" << std::endl;
+        header << "template <typename T>" << std::endl;
+        header << "void Encode(std::string& out, const std::vector<T>& v)" << std::endl;
+        header << "{" << std::endl;
+        header << "Encode(out, (std::uint32_t)v.size());" << std::endl;
+        header << "if constexpr (std::is_trivially_copyable<T>::value) out.append((const char*)v.data(), v.size() * sizeof(T));" << std::endl;
+        header << "else for (const T& e : v) Encode(out, e);" << std::endl;
+        header << "}" << std::endl;
+        header << "template <typename T>" << std::endl;
+        header << "bool Decode(const char*& in, const char* end, std::vector<T>& v)" << std::endl;
+        header << "{" << std::endl;
+        header << "std::uint32_t n;" << std::endl;
+        header << "if (!Decode(in, end, n) || (std::size_t)(end - in) < n) return false;" << std::endl;
+        header << "if constexpr (std::is_trivially_copyable<T>::value)" << std::endl;
+        header << "{" << std::endl;
+        header << "if ((std::size_t)(end - in) < n * sizeof(T)) return false;" << std::endl;
+        header << "v.resize(n); std::memcpy(v.data(), in, n * sizeof(T)); in += n * sizeof(T); return true;" << std::endl;
+        header << "}" << std::endl;
+        header << "else" << std::endl;
+        header << "{" << std::endl;
+        header << "v.resize(n);" << std::endl;
+        header << "for (T& e : v) if (!Decode(in, end, e)) return false;" << std::endl;
+        header << "return true;" << std::endl;
+        header << "}" << std::endl;
+        header << "}" << std::endl;
+        header << "template <typename L> constexpr bool Adjacent(std::size_t i) { return L::trivial[i] && L::trivial[i + 1] && L::offsets[i] + L::sizes[i] == L::offsets[i + 1]; }" << std::endl;
+        header << "template <typename L> constexpr bool RunStart(std::size_t i) { return L::trivial[i] && (i == 0 || !Adjacent<L>(i - 1)); }" << std::endl;
+        header << "template <typename L> constexpr std::size_t RunBytes(std::size_t i)" << std::endl;
+        header << "{" << std::endl;
+        header << "std::size_t j = i;" << std::endl;
+        header << "while (j + 1 < L::count && Adjacent<L>(j)) j++;" << std::endl;
+        header << "return L::offsets[j] + L::sizes[j] - L::offsets[i];" << std::endl;
+        header << "}}" << std::endl;
+        header << std::endl;
+    }
+
+    // 'pool' namespace that is put in the header once if any struct is @pooled
+    // Pool<T> keeps freed T sized blocks in thread local free list, at most maxCached of them per thread
+    // blocks freed on another thread go to list of that thread, derived types (other sizes) use global new/delete
+    // FreeList is trivially destructible so frees during thread/static destruction are safe, Drain returns cached blocks
+    inline void dumpPoolPreamble(std::ostream& header)
+    {
+        header << "namespace pool {" << std::endl;
+        header << "struct Stats { std::uint64_t allocations = 0; std::uint64_t reused = 0; std::uint64_t frees = 0; std::uint64_t cached = 0; };" << std::endl;
+        header << "template <typename T> struct Pool" << std::endl;
+        header << "{" << std::endl;
+        header << "static constexpr std::uint64_t maxCached = 4096;" << std::endl;
+        header << "static constexpr std::size_t blockSize = sizeof(T) < sizeof(void*) ? sizeof(void*) : sizeof(T);" << std::endl;
+        header << "struct FreeList { void* head; bool closed; Stats stats; };" << std::endl;
+        header << "static FreeList& List() { thread_local FreeList list{}; return list; }" << std::endl;
+        header << "struct Drain" << std::endl;
+        header << "{" << std::endl;
+        header << "~Drain()" << std::endl;
+        header << "{" << std::endl;
+        header << "FreeList& list = List();" << std::endl;
+        header << "list.closed = true;" << std::endl;
+        header << "while (list.head != nullptr) { void* next = *(void**)list.head; ::operator delete(list.head); list.head = next; }" << std::endl;
+        header << "list.stats.cached = 0;" << std::endl;
+        header << "}" << std::endl;
+        header << "};" << std::endl;
+        header << "static const Stats& ThreadStats() { return List().stats; }" << std::endl;
+        header << "static void* Allocate(std::size_t size)" << std::endl;
+        header << "{" << std::endl;
+        header << "static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, \"@pooled struct cannot be over aligned\");" << std::endl;
+        header << "FreeList& list = List();" << std::endl;
+        header << "list.stats.allocations++;" << std::endl;
+        header << "if (size != sizeof(T))" << std::endl;
+        header << "return ::operator new(size);" << std::endl;
+        header << "if (list.head == nullptr)" << std::endl;
+        header << "{" << std::endl;
+        header << "thread_local Drain drain;" << std::endl;
+        header << "(void)drain;" << std::endl;
+        header << "return ::operator new(blockSize);" << std::endl;
+        header << "}" << std::endl;
+        header << "void* p = list.head;" << std::endl;
+        header << "list.head = *(void**)p;" << std::endl;
+        header << "list.stats.cached--;" << std::endl;
+        header << "list.stats.reused++;" << std::endl;
+        header << "return p;" << std::endl;
+        header << "}" << std::endl;
+        header << "static void Free(void* p, std::size_t size)" << std::endl;
+        header << "{" << std::endl;
+        header << "FreeList& list = List();" << std::endl;
+        header << "list.stats.frees++;" << std::endl;
+        header << "if (size != sizeof(T) || list.closed || list.stats.cached >= maxCached) { ::operator delete(p); return; }" << std::endl;
+        header << "*(void**)p = list.head;" << std::endl;
+        header << "list.head = p;" << std::endl;
+        header << "list.stats.cached++;" << std::endl;
+        header << "}" << std::endl;
+        header << "};}" << std::endl;
+        header << std::endl;
+    }
+
+    // 'profile' namespace that is put in the header once if any body has MONOLITH_PROFILE_SCOPE
+    // each thread writes complete events to its own ring buffer (newest Buffer::size are kept), no locks on that path
+    // WriteChromeTrace exports all buffers for chrome://tracing or Perfetto, call it when profiled threads are idle
+    // MONOLITH_NO_PROFILE compiles scopes out
+    inline void dumpProfilePreamble(std::ostream& header)
+    {
+        header << "namespace profile {" << std::endl;
+        header << "struct Event { const char* name; std::int64_t start; std::int64_t duration; };" << std::endl;
+        header << "struct Buffer" << std::endl;
+        header << "{" << std::endl;
+        header << "static constexpr std::uint32_t size = 1 << 16;" << std::endl;
+        header << "Event events[size];" << std::endl;
+        header << "std::atomic<std::uint32_t> count{ 0 };" << std::endl;
+        header << "std::uint32_t thread = 0;" << std::endl;
+        header << "};" << std::endl;
+        header << "inline std::mutex& Mutex() { static std::mutex m; return m; }" << std::endl;
+        header << "inline std::vector<Buffer*>& Buffers() { static std::vector<Buffer*> b; return b; }" << std::endl;
+        header << "inline std::vector<Buffer*>& FreeBuffers() { static std::vector<Buffer*> b; return b; }" << std::endl;
+        header << "inline std::int64_t Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }" << std::endl;
+        header << "// buffers are never freed so events of finished threads can still be exported," << std::endl;
+        header << "// new threads reuse buffers of finished ones (and their tid) so there are only as many as threads alive at once" << std::endl;
+        header << "struct ThreadSlot" << std::endl;
+        header << "{" << std::endl;
+        header << "Buffer* buffer;" << std::endl;
+        header << "ThreadSlot()" << std::endl;
+        header << "{" << std::endl;
+        header << "std::lock_guard<std::mutex> lock(Mutex());" << std::endl;
+        header << "if (FreeBuffers().empty())" << std::endl;
+        header << "{" << std::endl;
+        header << "buffer = new Buffer();" << std::endl;
+        header << "buffer->thread = (std::uint32_t)Buffers().size();" << std::endl;
+        header << "Buffers().push_back(buffer);" << std::endl;
+        header << "}" << std::endl;
+        header << "else" << std::endl;
+        header << "{" << std::endl;
+        header << "buffer = FreeBuffers().back();" << std::endl;
+        header << "FreeBuffers().pop_back();" << std::endl;
+        header << "}" << std::endl;
+        header << "}" << std::endl;
+        header << "~ThreadSlot() { std::lock_guard<std::mutex> lock(Mutex()); FreeBuffers().push_back(buffer); }" << std::endl;
+        header << "};" << std::endl;
+        header << "inline Buffer& ThreadBuffer()" << std::endl;
+        header << "{" << std::endl;
+        header << "thread_local ThreadSlot slot;" << std::endl;
+        header << "return *slot.buffer;" << std::endl;
+        header << "}" << std::endl;
+        header << "struct Scope" << std::endl;
+        header << "{" << std::endl;
+        header << "const char* name;" << std::endl;
+        header << "std::int64_t start;" << std::endl;
+        header << "explicit Scope(const char* n) : name(n), start(Now()) {}" << std::endl;
+        header << "~Scope()" << std::endl;
+        header << "{" << std::endl;
+        header << "Buffer& b = ThreadBuffer();" << std::endl;
+        header << "std::uint32_t i = b.count.load(std::memory_order_relaxed);" << std::endl;
+        header << "b.events[i % Buffer::size] = { name, start, Now() - start };" << std::endl;
+        header << "b.count.store(i + 1, std::memory_order_release);" << std::endl;
+        header << "}" << std::endl;
+        header << "};" << std::endl;
+        header << "inline void WriteChromeTrace(std::ostream& out)" << std::endl;
+        header << "{" << std::endl;
+        header << "std::lock_guard<std::mutex> lock(Mutex());" << std::endl;
+        header << "const char* separator = \"\";" << std::endl;
+        header << "std::ios::fmtflags flags = out.flags();" << std::endl;
+        header << "std::streamsize precision = out.precision(3);" << std::endl;
+        header << "out << std::fixed;" << std::endl;
+        header << "out << \"{\\\"traceEvents\\\":[\";" << std::endl;
+        header << "for (Buffer* b : Buffers())" << std::endl;
+        header << "{" << std::endl;
+        header << "std::uint32_t count = b->count.load(std::memory_order_acquire);" << std::endl;
+        header << "for (std::uint32_t i = count > Buffer::size ? count - Buffer::size : 0; i < count; i++)" << std::endl;
+        header << "{" << std::endl;
+        header << "const Event& e = b->events[i % Buffer::size];" << std::endl;
+        header << "out << separator << \"{\\\"name\\\":\\\"\" << e.name << \"\\\",\\\"ph\\\":\\\"X\\\",\\\"pid\\\":0,\\\"tid\\\":\" << b->thread" << std::endl;
+        header << "<< \",\\\"ts\\\":\" << e.start / 1000.0 << \",\\\"dur\\\":\" << e.duration / 1000.0 << \"}\";" << std::endl;
+        header << "separator = \",\";" << std::endl;
+        header << "}" << std::endl;
+        header << "}" << std::endl;
+        header << "out << \"]}\" << std::endl;" << std::endl;
+        header << "out.flags(flags);" << std::endl;
+        header << "out.precision(precision);" << std::endl;
+        header << "}}" << std::endl;
+        header << "#ifdef MONOLITH_NO_PROFILE" << std::endl;
+        header << "#define MONOLITH_PROFILE_SCOPE(name)" << std::endl;
+        header << "#else" << std::endl;
+        header << "#define MONOLITH_PROFILE_SCOPE(name) profile::Scope _profileScope(name)" << std::endl;
+        header << "#endif" << std::endl;
+        header << std::endl;
+    }
+
+    // removes default arguments from 'template <typename T = int, int N = 3>'
+    // defaults cannot be repeated so they stay only in forward declaration
+    inline string removeTemplateDefaults(const string& templ)
+    {
+        string result;
+        int depth = 0; // <> and () nesting, 1 means template parameter list
+        bool skip = false;
+
+        for (char c : templ)
+        {
+            if (c == '<' || c == '(')
+                depth++;
+            else if (c == '>' || c == ')')
+                depth--;
+
+            if (depth == 1 && c == '=')
+                skip = true;
+            else if ((depth == 1 && c == ',') || depth == 0)
+                skip = false;
+
+            if (!skip)
+                result += c;
+        }
+
+        // 'T = int, ' leaves 'T , '
+        return std::regex_replace(result, compiledRegex("\\s+([,>])"), "$1");
+    }
+
+    // name declared by one declarator declaration e.g. 'int a[4] = {};' -> a
+    // returns "" if there is no name
+    inline string declaratorName(const string& decl)
+    {
+        string d = decl.substr(0, decl.find_first_of("={;"));
+        auto id = firstMatch(d, "[_a-zA-Z0-9]+\\s*(\\[[^\\]]*\\]\\s*)*$");
+
+        if (id.position == -1)
+            return "";
+
+        return firstMatch(id.str, "[_a-zA-Z0-9]+").str;
+    }
+
+    // erases first '//' to the end and white space before it
+    inline void removeLineCommentInPlace(string& s)
+    {
+        size_t comment = s.find("//");
+
+        if (comment == string::npos)
+            return;
+
+        while (comment > 0 && isspace((unsigned char)s.at(comment - 1)))
+            comment--;
+
+        s.erase(comment);
+    }
+
+    inline bool endsWith(std::string_view s, std::string_view end)
+    {
+        if (s.length() < end.length())
+            return false;
+
+        return s.substr(s.length() - end.length()) == end;
+    }
+
+    inline bool IsMethodProto(const string& str)
+    {
+        return (str.back() == ')' || util::endsWith(str, "const") || util::endsWith(str, "override"));
+    }
+
+    // evaluates #pragma compileif expression e.g. 'WIN && (DEBUG || !FAST)', flag is true if it is in flags
+    inline bool evalFlags(const string& expr, const std::unordered_set<string>& flags)
+    {
+        size_t i = 0;
+        std::function<bool()> orExpr, andExpr, unary;
+
+        auto skip = [&]()
+        {
+            while (i < expr.length() && (expr.at(i) == ' ' || expr.at(i) == '\t'))
+                i++;
+        };
+
+        auto error = [&]()
+        {
+            throw std::runtime_error(("bad #pragma compileif expression " + expr).c_str());
+        };
+
+        unary = [&]()
+        {
+            skip();
+
+            if (i < expr.length() && expr.at(i) == '!')
+            {
+                i++;
+                return !unary();
+            }
+
+            if (i < expr.length() && expr.at(i) == '(')
+            {
+                i++;
+                bool value = orExpr();
+                skip();
+
+                if (i >= expr.length() || expr.at(i) != ')')
+                    error();
+
+                i++;
+                return value;
+            }
+
+            size_t start = i;
+            while (i < expr.length() && string("()!&| \t").find(expr.at(i)) == string::npos)
+                i++;
+
+            if (start == i)
+                error();
+
+            return flags.count(expr.substr(start, i - start)) != 0;
+        };
+
+        // both sides are always parsed so errors are found even if result is already known
+        andExpr = [&]()
+        {
+            bool value = unary();
+            skip();
+
+            while (expr.compare(i, 2, "&&") == 0)
+            {
+                i += 2;
+                value = unary() && value;
+                skip();
+            }
+
+            return value;
+        };
+
+        orExpr = [&]()
+        {
+            bool value = andExpr();
+            skip();
+
+            while (expr.compare(i, 2, "||") == 0)
+            {
+                i += 2;
+                value = andExpr() || value;
+                skip();
+            }
+
+            return value;
+        };
+
+        bool value = orExpr();
+        skip();
+
+        if (i != expr.length())
+            error();
+
+        return value;
+    }
+
+    // 'out.h' -> 'out.debug.h'
+    inline string variantFileName(const string& path, const string& variant)
+    {
+        size_t dot = path.rfind('.');
+        size_t slash = path.find_last_of("/\\");
+
+        if (dot == string::npos || (slash != string::npos && dot < slash))
+            return path + "." + variant;
+
+        return path.substr(0, dot) + "." + variant + path.substr(dot);
+    }
+
+    // args with '@file' replaced by lines of the file (one argument per line), response files can be nested
+    inline vector<string> expandResponseFiles(const vector<string>& args, int depth = 0)
+    {
+        vector<string> result;
+
+        for (const string& arg : args)
+        {
+            if (!startsWith(arg, "@"))
+            {
+                result.push_back(arg);
+                continue;
+            }
+
+            if (depth > 8)
+                throw std::runtime_error(("response files nested too deep in " + arg).c_str());
+
+            std::ifstream file(arg.substr(1));
+
+            if (!file.is_open())
+                throw std::runtime_error(("could not open " + arg.substr(1)).c_str());
+
+            vector<string> lines;
+            string line;
+
+            while (std::getline(file, line))
+            {
+                if (line.length() > 0 && line.back() == '\r')
+                    line.pop_back();
+
+                line = trim(line);
+
+                if (line.length() != 0)
+                    lines.push_back(line);
+            }
+
+            for (const string& s : expandResponseFiles(lines, depth + 1))
+                result.push_back(s);
+        }
+
+        return result;
+    }
+
+    // '**/' is any number of directories, '*' and '?' dont match '/'
+    inline std::regex globRegex(const string& glob)
+    {
+        string regex;
+
+        for (int i = 0; i < (int)glob.length(); i++)
+        {
+            char c = glob.at(i);
+
+            if (glob.compare(i, 3, "**/") == 0)
+            {
+                regex += "(.*/)?";
+                i += 2;
+            }
+            else if (glob.compare(i, 2, "**") == 0)
+            {
+                regex += ".*";
+                i++;
+            }
+            else if (c == '*')
+                regex += "[^/]*";
+            else if (c == '?')
+                regex += "[^/]";
+            else if (string("\\.^$|()[]{}+").find(c) != string::npos)
+                regex += string("\\") + c;
+            else
+                regex += c;
+        }
+
+        return std::regex(regex);
+    }
+
+    // expands directories (all .cpp files in them recursively) and glob patterns e.g. 'src/**/*.cpp'
+    // with one directory scan per argument, each expansion is sorted so output is deterministic
+    // files that are there more times are kept only once, other args ('-', '-0' too) are kept as they are
+    inline vector<string> expandInputs(const vector<string>& inputs)
+    {
+        namespace fs = std::filesystem;
+        vector<string> result;
+        std::unordered_set<string> seen;
+
+        for (const string& input : inputs)
+        {
+            vector<string> expanded;
+            size_t wildcard = input.find_first_of("*?");
+
+            if (input == "-" || input == "-0" || (wildcard == string::npos && !fs::is_directory(input)))
+            {
+                expanded.push_back(input);
+            }
+            else if (wildcard == string::npos)
+            {
+                for (auto& entry : fs::recursive_directory_iterator(input))
+                    if (entry.is_regular_file() && entry.path().extension() == ".cpp")
+                        expanded.push_back(entry.path().generic_string());
+
+                std::sort(expanded.begin(), expanded.end());
+            }
+            else
+            {
+                // scan starts in the deepest directory without wildcards, it is recursive only if pattern has '/' after it
+                string base = input.substr(0, input.rfind('/', wildcard) + 1);
+                bool recursive = input.find('/', wildcard) != string::npos;
+                std::regex pattern = globRegex(input);
+
+                auto match = [&](const fs::directory_entry& entry)
+                {
+                    // "./" is not in the pattern if base is empty
+                    string path = entry.path().generic_string();
+                    if (base.length() == 0)
+                        path = path.substr(2);
+
+                    if (entry.is_regular_file() && std::regex_match(path, pattern))
+                        expanded.push_back(path);
+                };
+
+                string dir = base.length() == 0 ? "." : base;
+
+                if (recursive)
+                    for (auto& entry : fs::recursive_directory_iterator(dir))
+                        match(entry);
+                else
+                    for (auto& entry : fs::directory_iterator(dir))
+                        match(entry);
+
+                if (expanded.size() == 0)
+                    throw std::runtime_error(("no files match " + input).c_str());
+
+                std::sort(expanded.begin(), expanded.end());
+            }
+
+            for (string& s : expanded)
+                if (seen.insert(s).second)
+                    result.push_back(s);
+        }
+
+        return result;
+    }
+}
+
+namespace util
+{
+    // reads lines from FILE* through fixed size buffer so stdin/pipe inputs are never held whole in memory
+    // '\0' ends a segment, bundles of files are 'name\0content\0name\0content\0...'
+    // once segment ends reader returns empty lines until NextSegment()
+    class LineReader
+    {
+    private:
+        FILE* file;
+        char buffer[1 << 16];
+        size_t pos;
+        size_t size;
+        bool ended;
+
+        // next char or -1 on eof
+        int Get()
+        {
+            if (pos == size)
+            {
+                size = fread(buffer, 1, sizeof(buffer), file);
+                pos = 0;
+
+                if (size == 0)
+                    return -1;
+            }
+
+            return (unsigned char)buffer[pos++];
+        }
+    public:
+        LineReader(FILE* f)
+            : file(f), pos(0), size(0), ended(false)
+        {
+        }
+
+        // reads line to str, returns what ended it: '\n', '\0' or -1 for eof
+        int ReadLine(string& str)
+        {
+            str.clear();
+
+            if (ended)
+                return -1;
+
+            int c;
+            while ((c = Get()) != -1 && c != '\n' && c != '\0')
+                str += (char)c;
+
+            ended = c != '\n';
+            return c;
+        }
+
+        // skips rest of current segment
+        void SkipSegment()
+        {
+            while (!ended)
+            {
+                int c = Get();
+                ended = c == -1 || c == '\0';
+            }
+        }
+
+        void NextSegment()
+        {
+            ended = false;
+        }
+    };
+}
+
+namespace monolith
+{
+    using std::vector;
+    using std::string;
+
+    enum class AccessSpecifier
+    {
+        Private, Public, NoSpecifier, Protected
+    };
+
+    class IDump
+    {
+    public:
+        virtual ~IDump()
+        {
+        }
+
+        virtual void Dump(std::ostream& header, std::ostream& source) = 0;
+
+        virtual const string& GetProto()
+        {
+            throw std::runtime_error("GetProto() used without override");
+        };
+
+        // line(s) for manifest, see Monolith::DumpManifest()
+        virtual void DumpManifest(std::ostream& /*manifest*/)
+        {
+        }
+    };
+
+    class BaseFunc
+    {
+    protected:
+        std::string body;
+        const std::string& _namespace; // interned by Monolith
+        std::string prototype;
+        std::string _template; // template line right before prototype
+        std::ostream* sink; // body goes directly to source while parsing, see StreamBody()
+        bool streamed; // implementation is already in source
+        uint64_t bodyHash; // computed as body is parsed because streamed body is not kept
+        string file; // original file for #line, empty if #line is not wanted
+        int protoLine; // where prototype starts in the original file
+        int bodyLine; // where '{' of the body is in the original file
+
+        // what goes to source before and after body
+        virtual void DumpSourceBegin(std::ostream& source) = 0;
+        virtual void DumpSourceEnd(std::ostream& source) = 0;
+
+        void DumpSource(std::ostream& source)
+        {
+            if (streamed)
+                return;
+
+            DumpSourceBegin(source);
+            DumpLine(source, bodyLine);
+            source << body;
+            DumpRestoreLine(source);
+            DumpSourceEnd(source);
+        }
+
+        // body lines are kept one to one so one #line before prototype and one before body are enough
+        void DumpLine(std::ostream& source, int line)
+        {
+            if (file.length() != 0)
+                source << util::lineDirective(line, file) << std::endl;
+        }
+
+        // what follows body is generated, #line goes back to source (see util::LineRestorer)
+        void DumpRestoreLine(std::ostream& source)
+        {
+            if (file.length() != 0)
+                source << util::restoreLineMarker << std::endl;
+        }
+    public:
+        BaseFunc(const string& ns, const string& templ)
+            : _namespace(ns), _template(templ), sink(nullptr), streamed(false), bodyHash(util::hash64("")), protoLine(0), bodyLine(0)
+        {
+        }
+
+        void SetLocation(const string& _file, int _protoLine, int _bodyLine)
+        {
+            file = _file;
+            protoLine = _protoLine;
+            bodyLine = _bodyLine;
+        }
+
+        // body is not kept, it is written to source as it is parsed
+        // prototype must be complete
+        void StreamBody(std::ostream& source)
+        {
+            DumpSourceBegin(source);
+            DumpLine(source, bodyLine);
+            sink = &source;
+        }
+
+        // end of body
+        void EndBody()
+        {
+            if (sink == nullptr)
+                return;
+
+            DumpRestoreLine(*sink);
+            DumpSourceEnd(*sink);
+            sink = nullptr;
+            streamed = true;
+        }
+
+        // constexpr and consteval functions must be visible to be evaluated at compile time
+        bool IsCompileTime()
+        {
+            string specifiers = prototype.substr(0, GetNameIndex(prototype));
+
+            return util::firstMatch(specifiers, "\\b(constexpr|consteval)\\b").position != -1;
+        }
+
+        // templates and compile time functions go to header with body
+        virtual bool IsHeaderOnly()
+        {
+            return _template.length() != 0 || IsCompileTime();
+        }
+
+        void AddProto(const string& s)
+        {
+            prototype += s;
+        }
+
+        // one line of body, '\n' is added
+        void AddBodyLine(const string& s)
+        {
+            bodyHash = util::hash64("\n", util::hash64(s, bodyHash));
+
+            if (sink != nullptr)
+            {
+                *sink << s << '\n';
+                return;
+            }
+
+            // most bodies are short, longer ones grow geometrically from there
+            if (body.length() == 0)
+                body.reserve(256);
+
+            body.append(s).push_back('\n');
+        }
+
+        // template line, prototype and body, what definition in header is made of
+        string GetHeaderText() const
+        {
+            return _template + "\n" + prototype + "\n" + body;
+        }
+
+        // declaration hash, body is part of the interface if it goes to header
+        uint64_t GetInterfaceHash()
+        {
+            uint64_t h = util::hash64(_template + "\n" + prototype);
+
+            return IsHeaderOnly() ? util::hashCombine(h, GetBodyHash()) : h;
+        }
+
+        virtual uint64_t GetBodyHash()
+        {
+            return bodyHash;
+        }
+
+        // e.g. 'game::Entity::Update', used in manifest and profile scopes
+        virtual string GetQualifiedName() = 0;
+
+        // name without namespace e.g. 'Add' or 'operator=='
+        string GetFuncName()
+        {
+            int index = GetNameIndex(prototype);
+
+            return util::trim(prototype.substr(index, prototype.find('(', index + 1) - index));
+        }
+
+        // where name starts
+        // this method assumes that name is right before first '('
+        int GetNameIndex(const string& proto)
+        {
+            // find first '('
+            int index = proto.find('(');
+            // find id
+            auto id = util::firstMatch(proto, "([~_a-zA-Z0-9]+\\s*\\()|( operator[^_a-zA-Z0-9])");
+
+            if (util::startsWith(id.str, " operator"))
+                return id.position + 1;
+
+            if (id.position == -1)
+            {
+                string msg = "BaseFunc::nameIndex() no id found before '(' in " + prototype;
+                throw std::runtime_error(msg.c_str());
+            }
+
+            return id.position;
+        }
+    };
+
+    class Method : public IDump, public BaseFunc
+    {
+    private:
+        std::string initializerList;
+        const string& structName; // interned by Monolith
+        bool inTemplate; // method of template struct
+        string implPrototype; // prototype in source e.g. 'void S::Update(float dt)', set by SplitProto
+
+        // no override/static and name qualified with struct name
+        void BuildImplProto()
+        {
+            implPrototype = prototype;
+
+            // remove override from impl
+            int overridePos = implPrototype.find("override");
+            if (overridePos != string::npos)
+                implPrototype.replace(overridePos, 8, "");
+
+            // remove static from impl
+            if (util::startsWith(implPrototype, "static "))
+                implPrototype.replace(0, 7, "");
+
+            implPrototype.insert(GetNameIndex(implPrototype), structName + "::");
+        }
+    public:
+        Method(const string& ns, const string& _struct, const string& templ, bool _inTemplate)
+            :BaseFunc(ns, templ), structName(_struct), inTemplate(_inTemplate)
+        {
+        }
+
+        // separate prototype from initializer list
+        void SplitProto()
+        {
+            int openparencounter = 0;
+
+            // for loop looks for a single ':' (not ::) thats outside of any parenthases
+            for(int i=0;i<(int)prototype.size();i++)
+            {
+                if (prototype.at(i) == '(')
+                    openparencounter++;
+                else if (prototype.at(i) == ')')
+                    openparencounter--;
+
+                // ':' can be the last character of malformed prototype
+                bool scope = i + 1 < (int)prototype.size() && prototype.at(i + 1) == ':';
+
+                if (prototype.at(i) == ':' && openparencounter == 0 && !scope)
+                {
+                    initializerList = prototype.substr(i);
+                    prototype = prototype.substr(0, i);
+                    break;
+                }
+                else if (prototype.at(i) == ':' && scope) // skipp ::
+                    i++;
+            }
+
+            util::trimInPlace(prototype);
+
+            // prototype is complete, what goes to source is known now so dumps only copy it
+            if (!IsHeaderOnly())
+                BuildImplProto();
+        }
+
+        const string& GetProto() override
+        {
+            return prototype;
+        }
+
+        bool IsHeaderOnly() override
+        {
+            return inTemplate || BaseFunc::IsHeaderOnly();
+        }
+
+        // initializer list is in source with body
+        uint64_t GetBodyHash() override
+        {
+            return util::hash64(initializerList, bodyHash);
+        }
+
+        string GetQualifiedName() override
+        {
+            return _namespace + "::" + structName + "::" + GetFuncName();
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "method", GetInterfaceHash(), GetBodyHash(), GetQualifiedName());
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            // whole method in struct body
+            if (IsHeaderOnly())
+            {
+                if (_template.length() != 0)
+                    header << _template << std::endl;
+
+                header << prototype << initializerList << std::endl;
+                header << body << std::endl;
+                return;
+            }
+
+            // prototype in header
+            header << prototype << ';' << std::endl;
+            header << std::endl;
+
+            DumpSource(source);
+        }
+    protected:
+        void DumpSourceBegin(std::ostream& source) override
+        {
+            // implementation in source
+            util::openNamespace(source, _namespace);
+            DumpLine(source, protoLine);
+            source << implPrototype << initializerList << std::endl;
+        }
+
+        void DumpSourceEnd(std::ostream& source) override
+        {
+            source << std::endl;
+        }
+    };
+
+    class Function : public BaseFunc, public IDump
+    {
+    public:
+        Function(const string& ns, const string& templ)
+            :BaseFunc(ns, templ)
+        {
+        }
+
+        bool IsMain() const
+        {
+            return util::startsWith(prototype, "int main(");
+        }
+
+        string GetQualifiedName() override
+        {
+            return IsMain() ? "main" : _namespace + "::" + GetFuncName();
+        }
+
+        const string& GetProto() override
+        {
+            return prototype;
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "function", GetInterfaceHash(), GetBodyHash(), GetQualifiedName());
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            // main
+            if (IsMain())
+            {
+                DumpSource(source);
+            }
+            else if (IsHeaderOnly())
+            {
+                util::openNamespace(header, _namespace);
+
+                if (_template.length() != 0)
+                    header << _template << std::endl;
+
+                header << prototype << std::endl;
+                header << body << std::endl;
+            }
+            else
+            {
+                // prototype in header
+                util::openNamespace(header, _namespace);
+                header << prototype << ";" << std::endl;
+                header << std::endl;
+
+                DumpSource(source);
+            }
+        }
+    protected:
+        void DumpSourceBegin(std::ostream& source) override
+        {
+            if (IsMain())
+                util::closeNamespace(source);
+            else
+                util::openNamespace(source, _namespace);
+
+            DumpLine(source, protoLine);
+            source << prototype << std::endl;
+        }
+
+        void DumpSourceEnd(std::ostream& source) override
+        {
+            if (IsMain())
+                source << std::endl;
+
+            source << std::endl;
+        }
+    };
+
+    // struct member
+    class Field : public IDump
+    {
+    private:
+        std::string prototype;
+        std::string coldStruct; // companion struct of @cold field, empty for hot fields
+    public:
+        Field(const string& proto, const string& _coldStruct = ""):
+            prototype(proto), coldStruct(_coldStruct)
+        {
+        }
+
+        const string& GetProto() override
+        {
+            return prototype;
+        }
+
+        bool IsCold() const
+        {
+            return coldStruct.length() != 0;
+        }
+
+        const string& GetColdStruct() const
+        {
+            return coldStruct;
+        }
+
+        // field name, this method assumes there is one declarator e.g. 'int a[4] = {};'
+        string GetName() const
+        {
+            string name = util::declaratorName(prototype);
+
+            if (name.length() == 0)
+            {
+                string msg = "Field::GetName() could not find id of a field: [" + prototype + "]";
+                throw std::runtime_error(msg.c_str());
+            }
+
+            return name;
+        }
+
+        // declaration without name and initializer e.g. 'static const int '
+        string GetType() const
+        {
+            string decl = prototype.substr(0, prototype.find_first_of("={;"));
+            return decl.substr(0, decl.rfind(GetName()));
+        }
+
+        // default member initializer e.g. '= 5;'
+        string GetInitializer() const
+        {
+            size_t pos = prototype.find_first_of("={");
+            return pos == string::npos ? "" : prototype.substr(pos);
+        }
+
+        bool IsStatic() const
+        {
+            return util::startsWith(prototype, "static ");
+        }
+
+        // pure virtual methods are one liners that end with ';' so they are parsed as fields
+        bool IsPureVirtual() const
+        {
+            return util::startsWith(prototype, "virtual ");
+        }
+
+        // declaration as it was written, used for companion struct of cold fields
+        void DumpDeclaration(std::ostream& header)
+        {
+            header << prototype << std::endl;
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            if (!IsCold())
+            {
+                header << prototype << std::endl;
+                return;
+            }
+
+            // cold field lives in the companion struct, only accessors stay in the struct
+            string name = GetName();
+            string type = "decltype(" + coldStruct + "::" + name + ")";
+
+            header << type << "& " << name << "() { return _Cold()." << name << "; }" << std::endl;
+            header << "const " << type << "& " << name << "() const { return _Cold()." << name << "; }" << std::endl;
+        }
+    };
+
+    enum class NodeColor
+    {
+        White, Gray, Black
+    };
+
+    // header level declaration: struct/class, enum class, using/typedef, ns variable, function
+    // nodes are dumped in one dependency order so everything is declared/defined before it is used
+    class Node : public IDump
+    {
+    protected:
+        NodeColor color;
+        vector<Node*> dependencies;
+
+        // adds dependencies on nodes mentioned in text
+        // structs are forward declared so they are dependencies only when byValue and not followed by * or &
+        // variables are dependencies only in initializers (vars), other nodes are dependencies when mentioned
+        // in qualified names first component that is a node counts e.g. 'Shape::Circle' -> Shape
+        // functions are dependencies when they are called, overloads are left in parse order
+        void FindDependenciesIn(string text, const std::unordered_map<string, vector<Node*>>& nodes, bool byValue, bool vars, int depth = 0)
+        {
+            util::Match m;
+
+            while ((m = util::firstMatch(text, "([_a-zA-Z0-9]+::)*([_a-zA-Z0-9]+)( )*[&\\*]?")).position != -1)
+            {
+                text = text.substr(m.position + m.str.length());
+                m.str = util::trim(m.str);
+                bool call = text.length() != 0 && text.front() == '(';
+
+                // is followed by * or &
+                bool indirect = m.str.back() == '*' || m.str.back() == '&';
+
+                if (indirect)
+                    m.str = util::trim(m.str.substr(0, m.str.length() - 1));
+
+                auto it = nodes.end();
+                util::Match id;
+                while ((id = util::firstMatch(m.str, "[_a-zA-Z0-9]+")).position != -1 && it == nodes.end())
+                {
+                    it = nodes.find(id.str);
+                    m.str = m.str.substr(id.position + id.str.length());
+                }
+
+                if (it == nodes.end())
+                    continue;
+
+                for (Node* n : it->second)
+                {
+                    bool needed = n->IsFunction() ? call : n->IsStruct() ? byValue && !indirect : n->IsType() || vars;
+
+                    if (n == this || !needed || (n->IsFunction() && IsFunction() && n->GetName() == GetName()))
+                        continue;
+
+                    if (std::find(dependencies.begin(), dependencies.end(), n) == dependencies.end())
+                        dependencies.push_back(n);
+
+                    // alias used by value needs complete aliased structs too, depth stops alias loops in bad input
+                    if (byValue && !indirect && depth < 16)
+                        FindDependenciesIn(n->GetAliasedText(), nodes, true, false, depth + 1);
+                }
+            }
+        }
+    public:
+        Node()
+            : color(NodeColor::White)
+        {
+        }
+
+        // nodes are shared by IRs of more variants, each of them orders them again
+        void ResetOrder()
+        {
+            color = NodeColor::White;
+            dependencies.clear();
+        }
+
+        // name that other nodes use to refer to this node, can be empty
+        virtual const string& GetName() const = 0;
+
+        virtual void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) = 0;
+
+        // structs are forward declared so they dont need to be defined before pointers/references to them
+        virtual bool IsStruct() const
+        {
+            return false;
+        }
+
+        // false for variables
+        virtual bool IsType() const
+        {
+            return true;
+        }
+
+        // functions, see FunctionNode
+        virtual bool IsFunction() const
+        {
+            return false;
+        }
+
+        // for aliases, whatever they stand for
+        virtual string GetAliasedText() const
+        {
+            return "";
+        }
+
+        virtual void DumpForwardDecl(std::ostream& /*header*/)
+        {
+        }
+
+        void Traverse(vector<Node*>& ordered)
+        {
+            if (color == NodeColor::Gray)
+                throw std::runtime_error(("dependency loop detected at " + GetName()).c_str());
+            else if (color == NodeColor::Black)
+                return;
+
+            color = NodeColor::Gray;
+
+            for (auto& e : dependencies)
+                e->Traverse(ordered);
+
+            color = NodeColor::Black;
+            ordered.push_back(this);
+        }
+    };
+
+    // functions are ordered with other nodes because header only ones (template, constexpr/consteval) can be used
+    // at compile time e.g. 'std::array<int, Size()> a;' and their bodies need prototypes of functions they call
+    class FunctionNode : public Node
+    {
+    private:
+        Function* function;
+        string name;
+    public:
+        FunctionNode(Function* _function)
+            : function(_function), name(_function->GetFuncName())
+        {
+        }
+
+        const string& GetName() const override
+        {
+            return name;
+        }
+
+        bool IsType() const override
+        {
+            return false;
+        }
+
+        bool IsFunction() const override
+        {
+            return true;
+        }
+
+        // definition in header needs complete types, variables and functions it uses
+        // prototype needs only types, structs are forward declared unless default arguments use them
+        void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) override
+        {
+            if (function->IsHeaderOnly())
+            {
+                FindDependenciesIn(function->GetHeaderText(), nodes, true, true);
+                return;
+            }
+
+            const string& prototype = function->GetProto();
+            size_t defaults = prototype.find('=');
+            FindDependenciesIn(prototype.substr(0, defaults), nodes, false, false);
+
+            if (defaults != string::npos)
+                FindDependenciesIn(prototype.substr(defaults), nodes, true, true);
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            function->DumpManifest(manifest);
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            function->Dump(header, source);
+        }
+    };
+
+    // the difference between variable and nsvariable is that ns variable needs to dump extern in header
+    // ns member
+    class NsVariable : public Node
+    {
+    private:
+        string prototype;
+        const string& _namespace; // interned by Monolith
+        string value; // in case of initialized variables
+        string name;
+
+        // splits decl and init if there is '='
+        void SplitDeclaration()
+        {
+            int equalpos = prototype.find('=');
+
+            if (equalpos == string::npos)
+                return;
+
+            value = prototype.substr(equalpos + 1);
+            prototype = prototype.substr(0, equalpos);
+        }
+    public:
+        NsVariable(const string& proto, const string& ns):
+            prototype(proto), _namespace(ns)
+        {
+            SplitDeclaration();
+            name = util::declaratorName(prototype);
+        }
+
+        int GetNameIndex() const
+        {
+            auto name = util::firstMatch(prototype, "[_a-z0-9A-Z]+;");
+            return name.position;
+        }
+
+        const string& GetName() const override
+        {
+            return name;
+        }
+
+        bool IsType() const override
+        {
+            return false;
+        }
+
+        // extern declaration needs only declared types, value is in source
+        void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) override
+        {
+            string decl = prototype.substr(0, prototype.find_first_of("={;"));
+            FindDependenciesIn(decl.substr(0, decl.rfind(name)), nodes, false, false);
+        }
+
+        // value is only in source
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "variable", util::hash64(prototype), util::hash64(value), _namespace + "::" + name);
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            util::openNamespace(header, _namespace);
+            header << "    extern " << prototype;
+
+            if (value.length() != 0)
+                header << ";";
+
+            header << std::endl;
+            header << std::endl;
+
+            util::openNamespace(source, _namespace);
+            source << prototype;
+
+            if (value.length() != 0)
+                source << '=' << value;
+
+            source << std::endl;
+            source << std::endl;
+        }
+    };
+
+    class EnumClass : public Node
+    {
+    private:
+        string prototype;
+        string name;
+        string body;
+        const string& _namespace; // interned by Monolith
+        string annotations; // e.g. '// @reflect' lines before enum
+    public:
+        EnumClass(const string& proto, const string& ns, const string& _annotations):
+            prototype(proto), _namespace(ns), annotations(_annotations)
+        {
+            int whereNameStarts = string("enum class ").length();
+
+            name = util::firstMatch(prototype.substr(whereNameStarts), "[_a-zA-Z0-9]+").str;
+        }
+
+        void AddBody(const string& str)
+        {
+            body += str;
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "enum", util::hash64(annotations + prototype + "\n" + body), util::hash64(""), _namespace + "::" + name);
+        }
+
+        const string& GetName() const override
+        {
+            return name;
+        }
+
+        // underlying type and enumerator values, enumerator names are not dependencies
+        void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) override
+        {
+            FindDependenciesIn(prototype.substr(prototype.find(name) + name.length()), nodes, true, false);
+
+            for (const string& decl : GetEnumeratorDecls())
+                if (decl.find('=') != string::npos)
+                    FindDependenciesIn(decl.substr(decl.find('=')), nodes, true, false);
+        }
+
+        // simple prototype is just enum class + name (no specifier part)
+        string GetSimplePrototype() const
+        {
+            return "enum class " + name;
+        }
+
+        bool HasAnnotation(const string& annotation) const
+        {
+            return util::hasAnnotation(annotations, annotation);
+        }
+
+        // enumerator names in declaration order, body is '{A,B = 5,C};' without line breaks
+        vector<string> GetEnumerators() const
+        {
+            vector<string> enumerators;
+
+            for (const string& decl : GetEnumeratorDecls())
+                enumerators.push_back(util::firstMatch(decl, "[_a-zA-Z0-9]+").str);
+
+            return enumerators;
+        }
+
+        // values of enumerators if all of them are integer literals or implicit
+        // returns false if any value is an expression that has to be evaluated by compiler
+        // values that do not fit long long (unsigned underlying types) are not known either
+        bool GetEnumeratorValues(vector<long long>& values) const
+        {
+            long long next = 0;
+
+            for (const string& decl : GetEnumeratorDecls())
+            {
+                size_t equalpos = decl.find('=');
+
+                if (equalpos != string::npos)
+                {
+                    string value = util::trim(decl.substr(equalpos + 1));
+
+                    if (util::firstMatch(value, "^-?(0[xX][0-9a-fA-F]+|[0-9]+)[uUlL]*$").position == -1)
+                        return false;
+
+                    // same bases as integer literal, '0x' hex, '0' octal
+                    bool negative = value.front() == '-';
+                    const char* digits = value.c_str() + (negative ? 1 : 0);
+                    int base = 10;
+
+                    if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+                    {
+                        base = 16;
+                        digits += 2;
+                    }
+                    else if (digits[0] == '0')
+                        base = 8;
+
+                    unsigned long long magnitude = 0;
+                    std::from_chars_result result = std::from_chars(digits, value.c_str() + value.length(), magnitude, base);
+
+                    // '09' is not octal
+                    if (result.ec != std::errc() || std::string_view(result.ptr).find_first_not_of("uUlL") != std::string_view::npos)
+                        return false;
+
+                    if (magnitude > (negative ? 0ull - (unsigned long long)LLONG_MIN : (unsigned long long)LLONG_MAX))
+                        return false;
+
+                    next = negative ? (long long)(0ull - magnitude) : (long long)magnitude;
+                }
+                else if (values.size() != 0 && values.back() == LLONG_MAX)
+                    return false;
+
+                values.push_back(next);
+
+                if (next != LLONG_MAX)
+                    next++;
+            }
+
+            return true;
+        }
+
+        // enumerator declarations in declaration order e.g. 'B = 5'
+        vector<string> GetEnumeratorDecls() const
+        {
+            vector<string> decls;
+            int openparencounter = 0;
+            int start = 1; // skip '{'
+
+            for (int i = 1; i < (int)body.size(); i++)
+            {
+                char c = body.at(i);
+
+                if (c == '(')
+                    openparencounter++;
+                else if (c == ')')
+                    openparencounter--;
+
+                // enumerators are separated by coma outside of any parenthases, last one ends with '}'
+                if ((c == ',' && openparencounter == 0) || c == '}')
+                {
+                    string decl = util::trim(body.substr(start, i - start));
+
+                    if (decl.length() != 0)
+                        decls.push_back(decl);
+
+                    start = i + 1;
+
+                    if (c == '}')
+                        break;
+                }
+            }
+
+            return decls;
+        }
+
+        bool IsReflected() const
+        {
+            return HasAnnotation("@reflect") || HasAnnotation("@strings");
+        }
+
+        // string_view name, enumerators, perfect hash tables, see util::perfectHash
+        void DumpReflection(std::ostream& header)
+        {
+            string fullName = _namespace + "::" + name;
+            vector<string> enumerators = GetEnumerators();
+
+            if (enumerators.size() == 0)
+            {
+                string msg = "@reflect enum class " + fullName + " has no enumerators";
+                throw std::runtime_error(msg.c_str());
+            }
+
+            vector<int> displacements, slots;
+            util::perfectHash(enumerators, displacements, slots);
+
+            util::openNamespace(header, "reflect");
+            header << "template <> struct Reflect<" << fullName << ">" << std::endl;
+            header << '{' << std::endl;
+            header << "static constexpr std::string_view name = \"" << fullName << "\";" << std::endl;
+            header << "static constexpr std::size_t count = " << enumerators.size() << ";" << std::endl;
+
+            header << "static constexpr std::string_view names[] = {";
+            for (int i = 0; i < (int)enumerators.size(); i++)
+                header << (i == 0 ? " \"" : ", \"") << enumerators.at(i) << '"';
+            header << " };" << std::endl;
+
+            header << "static constexpr " << fullName << " values[] = {";
+            for (int i = 0; i < (int)enumerators.size(); i++)
+                header << (i == 0 ? " " : ", ") << fullName << "::" << enumerators.at(i);
+            header << " };" << std::endl;
+
+            header << "static constexpr int displacements[] = {";
+            for (int i = 0; i < (int)displacements.size(); i++)
+                header << (i == 0 ? " " : ", ") << displacements.at(i);
+            header << " };" << std::endl;
+
+            header << "static constexpr int slots[] = {";
+            for (int i = 0; i < (int)slots.size(); i++)
+                header << (i == 0 ? " " : ", ") << slots.at(i);
+            header << " };" << std::endl;
+
+            // index of enumerator in names/values or -1
+            header << "static constexpr int Index(std::string_view s)" << std::endl;
+            header << '{' << std::endl;
+            header << "int d = displacements[Hash(s, 0) % count];" << std::endl;
+            header << "int i = slots[d < 0 ? -d - 1 : Hash(s, (std::uint32_t)d) % count];" << std::endl;
+            header << "return names[i] == s ? i : -1;" << std::endl;
+            header << '}' << std::endl;
+            header << "};" << std::endl;
+            header << std::endl;
+        }
+
+        // ToString is dense array lookup if values are known and not sparse, scan of reflection tables otherwise
+        // FromString uses perfect hash from reflection
+        void DumpStrings(std::ostream& header)
+        {
+            string reflect = "::reflect::Reflect<" + name + ">";
+            vector<string> enumerators = GetEnumerators();
+            vector<long long> values;
+
+            util::openNamespace(header, _namespace);
+            header << "constexpr std::string_view ToString(" << name << " e)" << std::endl;
+            header << '{' << std::endl;
+
+            // sparse values like flags would make the table huge
+            bool dense = GetEnumeratorValues(values);
+            long long min = dense ? *std::min_element(values.begin(), values.end()) : 0;
+            long long max = dense ? *std::max_element(values.begin(), values.end()) : 0;
+            dense = dense && (unsigned long long)max - (unsigned long long)min < 4 * values.size() + 16;
+
+            if (dense)
+            {
+                // holes are empty strings, aliases keep the first name
+                vector<string> table(max - min + 1);
+                for (int i = (int)values.size() - 1; i >= 0; i--)
+                    table.at(values.at(i) - min) = enumerators.at(i);
+
+                header << "constexpr std::string_view table[] = {";
+                for (int i = 0; i < (int)table.size(); i++)
+                    header << (i == 0 ? " \"" : ", \"") << table.at(i) << '"';
+                header << " };" << std::endl;
+                // unsigned so any value of e and min = LLONG_MIN do not overflow, values below min wrap past the table
+                header << "unsigned long long i = (unsigned long long)e - " << (unsigned long long)min << "ULL;" << std::endl;
+                header << "return i >= 0 && i < " << table.size() << " ? table[i] : std::string_view();" << std::endl;
+            }
+            else
+            {
+                // switch would have duplicate case values for aliases e.g. 'B = A'
+                header << "for (std::size_t i = 0; i < " << reflect << "::count; i++)" << std::endl;
+                header << "if (" << reflect << "::values[i] == e) return " << reflect << "::names[i];" << std::endl;
+                header << "return std::string_view();" << std::endl;
+            }
+
+            header << '}' << std::endl;
+            header << std::endl;
+
+            header << "constexpr bool FromString(std::string_view s, " << name << "& e)" << std::endl;
+            header << '{' << std::endl;
+            header << "int i = " << reflect << "::Index(s);" << std::endl;
+            header << "if (i < 0) return false;" << std::endl;
+            header << "e = " << reflect << "::values[i];" << std::endl;
+            header << "return true;" << std::endl;
+            header << "}" << std::endl;
+            header << std::endl;
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            util::openNamespace(header, _namespace);
+            header << prototype << std::endl;
+            header << body << std::endl;
+            header << std::endl;
+
+            if (IsReflected())
+                DumpReflection(header);
+
+            if (HasAnnotation("@strings"))
+                DumpStrings(header);
+        }
+    };
+
+    class Using : public Node
+    {
+    private:
+        string prototype;
+        const string& _namespace; // interned by Monolith
+        string name; // empty for 'using namespace'
+        string aliased; // what name stands for e.g. 'std::vector<int>'
+    public:
+        Using(const string& proto, const string& ns) 
+            :prototype(proto), _namespace(ns)
+        {
+            string decl = prototype.substr(0, prototype.rfind(';'));
+            size_t equalpos = decl.find('=');
+
+            if (util::startsWith(decl, "typedef"))
+            {
+                // function pointer typedef 'typedef void (*Fn)(int);'
+                auto fnptr = util::firstMatch(decl, "\\(\\s*\\*\\s*[_a-zA-Z0-9]+\\s*\\)");
+                name = fnptr.position != -1 ? util::firstMatch(fnptr.str, "[_a-zA-Z0-9]+").str : util::declaratorName(decl);
+                aliased = decl.substr(7);
+                size_t namepos = aliased.rfind(name);
+
+                // malformed e.g. 'typedef= Vec Box;', parser reports typedef without name
+                if (name.length() == 0 || namepos == string::npos)
+                    name.clear();
+                else
+                    aliased.erase(namepos, name.length());
+            }
+            else if (equalpos != string::npos)
+            {
+                name = util::firstMatch(decl.substr(5), "[_a-zA-Z0-9]+").str;
+                aliased = decl.substr(equalpos + 1);
+            }
+            else if (!util::startsWith(decl, "using namespace"))
+            {
+                // using declaration 'using std::vector;'
+                name = util::declaratorName(decl);
+            }
+        }
+
+        const string& GetName() const override
+        {
+            return name;
+        }
+
+        string GetAliasedText() const override
+        {
+            return aliased;
+        }
+
+        // alias itself can refer to declared struct, complete struct is needed where alias is used by value
+        void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) override
+        {
+            FindDependenciesIn(aliased, nodes, false, false);
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "using", util::hash64(prototype), util::hash64(""), _namespace + "::" + (name.length() != 0 ? name : prototype));
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            util::openNamespace(header, _namespace);
+            header << "    " << prototype << std::endl;
+            header << std::endl;
+        }
+    };
+
+    /*enum class SCType
+    {
+        Struct, Class
+    };*/
+
+    class StructClass : public Node
+    {
+    protected:
+        string _template;
+        string prototype;
+        string name;
+        const string& _namespace; // interned by Monolith
+        vector<IDump*> members; // outside private/public
+        vector<IDump*> privateMembers;
+        vector<IDump*> publicMembers;
+        vector<IDump*> protectedMembers;
+        vector<Field*> fields; // also in one of the above
+        vector<Method*> methods; // also in one of the above
+        string annotations; // e.g. '// @soa' lines before struct
+
+        // method prototypes need only declared types
+        void FindDependenciesIn(const std::unordered_map<string, vector<Node*>>& nodes, vector<IDump*>& v)
+        {
+            for (IDump* i : v)
+            {
+                const string& proto = i->GetProto();
+
+                if (proto.back() == ';')
+                    continue;
+
+                // method name is not a call of function with the same name
+                auto id = util::firstMatch(proto, "[~_a-zA-Z0-9]+\\s*\\(");
+
+                if (id.position == -1)
+                    Node::FindDependenciesIn(proto, nodes, false, false);
+                else
+                    Node::FindDependenciesIn(proto.substr(0, id.position) + proto.substr(id.position + id.str.length() - 1), nodes, false, false);
+            }
+        }
+    public:
+        StructClass(const string& proto, const string& ns, const string& templ):
+            prototype(proto), _namespace(ns), _template(templ)
+        {
+            auto match = util::firstMatch(prototype, " [_a-zA-Z0-9]+");
+            name = match.str.substr(1); // substr(1) because it starts with space
+        }
+
+        const string& GetName() const override
+        {
+            return name;
+        }
+
+        bool IsStruct() const override
+        {
+            return true;
+        }
+
+        // to find dependencies find all words that dont end with & or * and that ar not identifiers or keywords
+        // example: s id1;  ->   dependends on s
+        //          s* id2; ->   no dependency
+        //          struct S : public S2 -> depends on S2
+        //          void   fun1(const s& _s1, Fish f); -> no dependency on struct Fish, alias/enum Fish would be
+        //          int x = Limits::Max; -> depends on Limits
+        void FindDependencies(const std::unordered_map<string, vector<Node*>>& nodes) override
+        {
+            int colonPos = prototype.find(':');            
+
+            // find inheritance dependencies
+            if (colonPos != string::npos)
+                Node::FindDependenciesIn(prototype.substr(colonPos), nodes, true, false);
+
+            Node::FindDependenciesIn(_template, nodes, false, false);
+
+            // static fields are only declared in struct, pure virtual methods are parsed as fields
+            for (Field* f : fields)
+            {
+                if (f->IsPureVirtual())
+                {
+                    Node::FindDependenciesIn(f->GetProto(), nodes, false, false);
+                    continue;
+                }
+
+                Node::FindDependenciesIn(f->GetType(), nodes, !f->IsStatic(), false);
+                Node::FindDependenciesIn(f->GetInitializer(), nodes, true, true);
+            }
+
+            FindDependenciesIn(nodes, members);
+            FindDependenciesIn(nodes, privateMembers);
+            FindDependenciesIn(nodes, protectedMembers);
+            FindDependenciesIn(nodes, publicMembers);
+        }
+
+        // return struct or class
+        /*SCType GetType() const
+        {
+            if (util::startsWith(prototype, "struct"))
+                return SCType::Struct;
+            else
+                return SCType::Class;
+        }*/
+
+        // simple prototype is just class/struct + name (no inheritance part)
+        string GetSimplePrototype() const
+        {
+            if (util::startsWith(prototype, "class"))
+                return "class " + name;
+            else if (util::startsWith(prototype, "struct"))
+                return "struct " + name;
+            else
+                return "union " + name;
+        }
+
+        // name of companion struct for @cold fields
+        string GetColdName() const
+        {
+            return name + "Cold";
+        }
+
+        bool HasColdFields() const
+        {
+            for (Field* f : fields)
+                if (f->IsCold())
+                    return true;
+
+            return false;
+        }
+
+        // name of struct of arrays container
+        string GetSoAName() const
+        {
+            return name + "SoA";
+        }
+
+        bool HasAnnotation(const string& annotation) const
+        {
+            return util::hasAnnotation(annotations, annotation);
+        }
+
+        void SetAnnotations(const string& _annotations)
+        {
+            annotations = _annotations;
+        }
+
+        // fields that are data members of the struct itself
+        vector<Field*> GetDataFields() const
+        {
+            vector<Field*> v;
+            for (Field* f : fields)
+                if (!f->IsStatic() && !f->IsPureVirtual() && !f->IsCold())
+                    v.push_back(f);
+
+            return v;
+        }
+
+        void AddField(Field* f, AccessSpecifier acc)
+        {
+            fields.push_back(f);
+            AddMember(f, acc);
+        }
+
+        void AddMethod(Method* m, AccessSpecifier acc)
+        {
+            methods.push_back(m);
+            AddMember(m, acc);
+        }
+
+        // everything that goes to header, methods that are in header with body are included
+        uint64_t GetInterfaceHash()
+        {
+            uint64_t h = util::hash64(annotations + _template + "\n" + prototype);
+
+            for (auto v : { &members, &privateMembers, &protectedMembers, &publicMembers })
+            {
+                h = util::hash64("\n", h);
+
+                for (IDump* i : *v)
+                    h = util::hash64(i->GetProto(), h);
+            }
+
+            // @cold is not in prototype but moves field to companion struct and adds accessor
+            for (Field* f : fields)
+                h = util::hash64(f->GetColdStruct() + "\n", h);
+
+            for (Method* m : methods)
+                h = util::hashCombine(h, m->GetInterfaceHash());
+
+            return h;
+        }
+
+        // bodies of methods that are in source
+        uint64_t GetBodyHash()
+        {
+            uint64_t h = util::hash64("");
+
+            for (Method* m : methods)
+                if (!m->IsHeaderOnly())
+                    h = util::hashCombine(h, m->GetBodyHash());
+
+            return h;
+        }
+
+        void DumpManifest(std::ostream& manifest) override
+        {
+            util::dumpManifestLine(manifest, "struct", GetInterfaceHash(), GetBodyHash(), _namespace + "::" + name);
+
+            for (Method* m : methods)
+                m->DumpManifest(manifest);
+        }
+
+        void AddMember(IDump* m, AccessSpecifier acc)
+        {
+            if (acc == AccessSpecifier::NoSpecifier)
+                members.push_back(m);
+            else if (acc == AccessSpecifier::Private)
+                privateMembers.push_back(m);
+            else if (acc == AccessSpecifier::Protected)
+                protectedMembers.push_back(m);
+            else if (acc == AccessSpecifier::Public)
+                publicMembers.push_back(m);
+        }
+
+        void DumpForwardDecl(std::ostream& header) override
+        {
+            util::openNamespace(header, _namespace);
+
+            if (_template.length() != 0)
+                header << _template << std::endl;
+
+            header << GetSimplePrototype() << ";" << std::endl;
+            header << std::endl;
+        }
+
+        void Dump(std::ostream& header, std::ostream& source) override
+        {
+            util::openNamespace(header, _namespace);
+            
+            // default template arguments are in forward declaration
+            if(_template.length() != 0)
+                header << util::removeTemplateDefaults(_template) << std::endl;
+
+            header << prototype << std::endl;
+            header << '{' << std::endl;
+
+            // companion struct must be declared before accessors use it
+            if (HasColdFields())
+            {
+                header << "struct " << GetColdName() << std::endl;
+                header << '{' << std::endl;
+
+                for (Field* f : fields)
+                    if (f->IsCold())
+                        f->DumpDeclaration(header);
+
+                header << "};" << std::endl;
+            }
+            
+            for (IDump* m : members)
+                m->Dump(header, source);
+
+            if (privateMembers.size() > 0)
+            {
+                header << "private:" << std::endl;
+            }
+
+            for (IDump* m : privateMembers)
+                m->Dump(header, source);
+
+            if (protectedMembers.size() > 0)
+            {
+                header << "protected:" << std::endl;
+            }
+
+            for (IDump* m : protectedMembers)
+                m->Dump(header, source);
+
+            if (publicMembers.size() > 0)
+            {
+                header << "public:" << std::endl;
+            }
+
+            for (IDump* m : publicMembers)
+                m->Dump(header, source);
+
+            // objects come from thread local free list of the type, derived types keep using global new
+            if (HasAnnotation("@pooled"))
+            {
+                header << "public:" << std::endl;
+                header << "static void* operator new(std::size_t size) { return ::pool::Pool<" << name << ">::Allocate(size); }" << std::endl;
+                header << "static void operator delete(void* p, std::size_t size) { ::pool::Pool<" << name << ">::Free(p, size); }" << std::endl;
+                header << "static const ::pool::Stats& PoolStats() { return ::pool::Pool<" << name << ">::ThreadStats(); }" << std::endl;
+            }
+
+            // companion is allocated on first access so hot only objects never pay for it
+            if (HasColdFields())
+            {
+                header << "private:" << std::endl;
+                header << "mutable std::unique_ptr<" << GetColdName() << "> _cold;" << std::endl;
+                header << GetColdName() << "& _Cold() const { if (!_cold) _cold.reset(new " << GetColdName() << "()); return *_cold; }" << std::endl;
+            }
+
+            // container and reflection read private fields too
+            if (HasAnnotation("@soa"))
+                header << "friend struct " << GetSoAName() << ";" << std::endl;
+
+            if (HasAnnotation("@reflect"))
+                header << "friend struct ::reflect::Reflect<" << name << ">;" << std::endl;
+
+            if (HasAnnotation("@serializable"))
+            {
+                header << "friend struct " << name << "Layout;" << std::endl;
+                header << "friend void Encode(std::string& out, const " << name << "& s);" << std::endl;
+                header << "friend bool Decode(const char*& in, const char* end, " << name << "& s);" << std::endl;
+            }
+
+            header << "};" << std::endl << std::endl;
+
+            if (HasAnnotation("@soa"))
+                DumpSoA(header);
+
+            if (HasAnnotation("@reflect"))
+                DumpReflection(header);
+
+            if (HasAnnotation("@serializable"))
+                DumpSerializers(header);
+        }
+
+        // NameLayout describes fields for serial::RunStart/RunBytes, they are evaluated at compile time
+        // so field i is either start of memcpy run, part of previous run or encoded on its own
+        void DumpSerializers(std::ostream& header)
+        {
+            if (_template.length() != 0)
+            {
+                string msg = "@serializable is not supported for template " + _namespace + "::" + name;
+                throw std::runtime_error(msg.c_str());
+            }
+
+            string layout = name + "Layout";
+            vector<string> names;
+            for (Field* f : GetDataFields())
+                names.push_back(f->GetName());
+
+            util::openNamespace(header, _namespace);
+
+            // zero size arrays are not allowed
+            if (names.size() > 0)
+            {
+                header << "struct " << layout << std::endl;
+                header << '{' << std::endl;
+                header << "static constexpr std::size_t count = " << names.size() << ";" << std::endl;
+
+                header << "static constexpr bool trivial[] = {";
+                for (int i = 0; i < (int)names.size(); i++)
+                    header << (i == 0 ? " " : ", ") << "std::is_trivially_copyable<decltype(" << name << "::" << names.at(i) << ")>::value";
+                header << " };" << std::endl;
+
+                header << "static constexpr std::size_t offsets[] = {";
+                for (int i = 0; i < (int)names.size(); i++)
+                    header << (i == 0 ? " " : ", ") << "offsetof(" << name << ", " << names.at(i) << ")";
+                header << " };" << std::endl;
+
+                header << "static constexpr std::size_t sizes[] = {";
+                for (int i = 0; i < (int)names.size(); i++)
+                    header << (i == 0 ? " " : ", ") << "sizeof(" << name << "::" << names.at(i) << ")";
+                header << " };" << std::endl;
+                header << "};" << std::endl;
+                header << std::endl;
+            }
+
+            header << "inline void Encode(std::string& out, const " << name << "& s)" << std::endl;
+            header << '{' << std::endl;
+            header << "using serial::Encode;" << std::endl;
+
+            for (int i = 0; i < (int)names.size(); i++)
+            {
+                header << "if constexpr (serial::RunStart<" << layout << ">(" << i << ")) ";
+                header << "out.append((const char*)&s + " << layout << "::offsets[" << i << "], serial::RunBytes<" << layout << ">(" << i << "));" << std::endl;
+                header << "else if constexpr (!" << layout << "::trivial[" << i << "]) Encode(out, s." << names.at(i) << ");" << std::endl;
+            }
+
+            header << '}' << std::endl;
+            header << std::endl;
+
+            header << "inline bool Decode(const char*& in, const char* end, " << name << "& s)" << std::endl;
+            header << '{' << std::endl;
+            header << "using serial::Decode;" << std::endl;
+
+            for (int i = 0; i < (int)names.size(); i++)
+            {
+                header << "if constexpr (serial::RunStart<" << layout << ">(" << i << "))" << std::endl;
+                header << "{" << std::endl;
+                header << "constexpr std::size_t n = serial::RunBytes<" << layout << ">(" << i << ");" << std::endl;
+                header << "if ((std::size_t)(end - in) < n) return false;" << std::endl;
+                header << "std::memcpy((char*)&s + " << layout << "::offsets[" << i << "], in, n); in += n;" << std::endl;
+                header << "}" << std::endl;
+                header << "else if constexpr (!" << layout << "::trivial[" << i << "]) { if (!Decode(in, end, s." << names.at(i) << ")) return false; }" << std::endl;
+            }
+
+            header << "return true;" << std::endl;
+            header << "}" << std::endl;
+            header << std::endl;
+        }
+
+        // string_view names, member pointers tuple and offsets of data fields
+        void DumpReflection(std::ostream& header)
+        {
+            if (_template.length() != 0)
+            {
+                string msg = "@reflect is not supported for template " + _namespace + "::" + name;
+                throw std::runtime_error(msg.c_str());
+            }
+
+            string fullName = _namespace + "::" + name;
+            vector<string> names;
+            for (Field* f : GetDataFields())
+                names.push_back(f->GetName());
+
+            util::openNamespace(header, "reflect");
+            header << "template <> struct Reflect<" << fullName << ">" << std::endl;
+            header << '{' << std::endl;
+            header << "static constexpr std::string_view name = \"" << fullName << "\";" << std::endl;
+            header << "static constexpr std::size_t count = " << names.size() << ";" << std::endl;
+
+            // zero size arrays are not allowed
+            if (names.size() > 0)
+            {
+                header << "static constexpr std::string_view names[] = {";
+                for (int i = 0; i < (int)names.size(); i++)
+                    header << (i == 0 ? " \"" : ", \"") << names.at(i) << '"';
+                header << " };" << std::endl;
+
+                header << "static constexpr std::size_t offsets[] = {";
+                for (int i = 0; i < (int)names.size(); i++)
+                    header << (i == 0 ? " " : ", ") << "offsetof(" << fullName << ", " << names.at(i) << ")";
+                header << " };" << std::endl;
+            }
+
+            header << "static constexpr auto members = std::make_tuple(";
+            for (int i = 0; i < (int)names.size(); i++)
+                header << (i == 0 ? "" : ", ") << '&' << fullName << "::" << names.at(i);
+            header << ");" << std::endl;
+            header << "};" << std::endl;
+            header << std::endl;
+        }
+
+        // struct of arrays container, one vector per field
+        // View is a struct of references to fields of one element
+        void DumpSoA(std::ostream& header)
+        {
+            if (_template.length() != 0)
+            {
+                string msg = "@soa is not supported for template " + _namespace + "::" + name;
+                throw std::runtime_error(msg.c_str());
+            }
+
+            vector<string> names;
+            for (Field* f : GetDataFields())
+                names.push_back(f->GetName());
+
+            if (names.size() == 0)
+            {
+                string msg = "@soa struct " + _namespace + "::" + name + " has no fields";
+                throw std::runtime_error(msg.c_str());
+            }
+
+            string soaName = GetSoAName();
+
+            util::openNamespace(header, _namespace);
+            header << "struct " << soaName << std::endl;
+            header << '{' << std::endl;
+
+            for (string& n : names)
+                header << "std::vector<decltype(" << name << "::" << n << ")> " << n << ";" << std::endl;
+
+            header << "struct View" << std::endl;
+            header << '{' << std::endl;
+
+            for (string& n : names)
+                header << "decltype(" << name << "::" << n << ")& " << n << ";" << std::endl;
+
+            header << "};" << std::endl;
+
+            // names.front() is the size of all of them
+            header << "std::size_t size() const { return " << names.front() << ".size(); }" << std::endl;
+
+            header << "void reserve(std::size_t n) {";
+            for (string& n : names)
+                header << ' ' << n << ".reserve(n);";
+            header << " }" << std::endl;
+
+            header << "void push_back(const " << name << "& e) {";
+            for (string& n : names)
+                header << ' ' << n << ".push_back(e." << n << ");";
+            header << " }" << std::endl;
+
+            header << "void erase(std::size_t i) {";
+            for (string& n : names)
+                header << ' ' << n << ".erase(" << n << ".begin() + i);";
+            header << " }" << std::endl;
+
+            header << "View operator[](std::size_t i) { return View{";
+            for (int i = 0; i < (int)names.size(); i++)
+                header << (i == 0 ? " " : ", ") << names.at(i) << "[i]";
+            header << " }; }" << std::endl;
+
+            header << "};" << std::endl << std::endl;
+        }
+    };
+
+    // in memory source file, see Generate()
+    struct InputFile
+    {
+        string name; // used in error messages
+        string content;
+    };
+
+    struct Options
+    {
+        vector<string> flags; // for #pragma compileif
+        string hfile; // what to #include in sources
+        int shards = 1;
+        bool lineDirectives = false; // #line before function bodies so errors and profilers point to input files
+        string sourceFile; // name of source for #line after bodies, shard i > 0 is named by util::variantFileName(sourceFile, "i")
+        string profile; // regex of qualified names e.g. '^game::Entity::' of functions that get profile scope, see @profile
+        int threads = 0; // for rendering output, 0 means number of cores
+    };
+
+    // objects IR is made of and strings they refer to, IRs of variants share storage of parts they are merged from
+    struct Storage
+    {
+        util::Interner names; // namespaces and struct names of nodes
+        vector<std::unique_ptr<IDump>> objects; // everything that was parsed
+    };
+
+    class Monolith
+    {
+    private:        
+        vector<string> includes;
+        std::unordered_set<string> flags; // for conditional file parsing
+        std::unordered_map<string,StructClass*> structClasses;
+        vector<NsVariable*> variables;
+        vector<EnumClass*> enums;
+        vector<Using*> usings;
+        Function* main;
+        vector<Node*> nodes; // header level declarations in parse order
+        vector<Node*> orderedNodes; // in dependency order
+        
+        int lineNum;
+        string filename; // currently parsed file, used to error messages
+        std::function<bool(string&)> next;  // read next source code line to the string, return true if eof
+        bool ended; // next() returned eof, reading past it is a syntax error (unterminated block/comment)
+        std::ostream* streamSource; // if set, function bodies go there as they are parsed
+        bool lineDirectives; // #line before function bodies in source
+        string sourceFile; // see Options::sourceFile
+        std::unordered_map<std::ostream*, std::unique_ptr<util::LineRestorer>> restorers; // see Restored()
+        string profile; // see Options::profile
+        std::regex profileFilter;
+        bool profiled; // some body has profile scope, profile runtime goes to header
+        int threads; // for Dump
+        bool variantPart; // IR of one file for more variants, see GenerateVariants
+        string condition; // #pragma compileif expression of variant part, empty means always
+        string currentNamespace;
+        std::shared_ptr<Storage> storage; // IR is freed with the last Monolith that uses it
+        vector<std::shared_ptr<Storage>> partStorage; // of variant parts this IR is merged from
+
+        //////////////////////////
+        //// PARSER FUNCTIONS ////
+        //////////////////////////
+
+        // parsed object is freed with storage
+        template <typename T>
+        T* Own(T* object)
+        {
+            storage->objects.emplace_back(object);
+            return object;
+        }
+
+        void enterNamespace(const string& str)
+        {
+            if (currentNamespace.length() > 0)
+                currentNamespace += "::";
+
+            currentNamespace += str;
+        }
+
+        void exitNamespace()
+        {
+            while (currentNamespace.length() > 0 && currentNamespace.back() != ':')
+                currentNamespace.pop_back();
+
+            if (currentNamespace.length() > 0)
+            {
+                currentNamespace.pop_back();
+                currentNamespace.pop_back();
+            }
+        }
+        
+        Function* ExtractFunction(string& line, const string& templ, const string& annotations)
+        {
+            Function* fun = Own(new Function(storage->names.Intern(currentNamespace), templ));
+            int protoLine = lineNum;
+
+            // get prototype first
+            fun->AddProto(line);
+            next(line);
+            util::removeLineCommentInPlace(line);
+
+            // prototype goes until line == '{'
+            while(line != "{")
+            {
+                fun->AddProto(line);
+                if (next(line))
+                    util::syntaxError(lineNum, filename, "unexpected EOF");
+                util::removeLineCommentInPlace(line);
+            }
+
+            if (lineDirectives)
+                fun->SetLocation(filename, protoLine, lineNum);
+
+            if (streamSource != nullptr && !fun->IsHeaderOnly())
+                fun->StreamBody(*streamSource);
+
+            // start counting braces
+            // fun body will end when matching '}' encountered
+            int openBrace = 1;
+
+            // get body
+            fun->AddBodyLine(BodyBegin(fun, line, annotations));
+
+            do
+            {
+                if (next(line))
+                    util::syntaxError(lineNum, filename, "unexpected EOF");
+
+                fun->AddBodyLine(line);
+
+                openBrace += std::count(line.begin(), line.end(), '{');
+                openBrace -= std::count(line.begin(), line.end(), '}');
+            } while (openBrace > 0); // keep going until matching closing brace
+
+            fun->EndBody();
+            return fun;
+        }
+
+        Method* ExtractMethod(string& line, const string& structName, const string& templ, bool inTemplate, const string& annotations)
+        {
+            Method* method = Own(new Method(storage->names.Intern(currentNamespace), storage->names.Intern(structName), templ, inTemplate));
+            int protoLine = lineNum;
+
+            // get prototype first
+            method->AddProto(line);
+            next(line);
+            util::removeLineCommentInPlace(line);
+
+            // prototype goes until line == '{'
+            while (line != "{")
+            {
+                method->AddProto(line);
+                if (next(line))
+                    util::syntaxError(lineNum, filename, "unexpected EOF");
+                util::removeLineCommentInPlace(line);
+            }
+            
+            method->SplitProto();
+
+            if (lineDirectives)
+                method->SetLocation(filename, protoLine, lineNum);
+
+            if (streamSource != nullptr && !method->IsHeaderOnly())
+                method->StreamBody(*streamSource);
+
+            // start counting braces
+            // fun body will end when matching '}' encountered
+            int openBrace = 1;
+
+            // get body
+            method->AddBodyLine(BodyBegin(method, line, annotations));
+
+            do
+            {
+                if (next(line))
+                    util::syntaxError(lineNum, filename, "unexpected EOF");
+
+                method->AddBodyLine(line);
+
+                openBrace += std::count(line.begin(), line.end(), '{');
+                openBrace -= std::count(line.begin(), line.end(), '}');
+            } while (openBrace > 0); // keep going until matching closing brace
+
+            method->EndBody();
+            return method;
+        }
+
+        EnumClass* ExtractEnumClass(const string& prototype, const string& annotations)
+        {
+            if (util::firstMatch(prototype, "^enum class [_a-zA-Z0-9]").position == -1)
+                util::syntaxError(lineNum, filename, "enum class name expected");
+
+            EnumClass* enumClass = Own(new EnumClass(prototype, storage->names.Intern(currentNamespace), annotations));
+
+            string line;
+
+            // next line must be '{'
+            next(line);
+            util::removeLineCommentInPlace(line);
+
+            if (line != "{")
+                util::syntaxError(lineNum, filename, "missing '{'");
+
+            enumClass->AddBody(line);
+
+            while (true)
+            {
+                next(line);
+
+                if (util::startsWith(line, "/*"))
+                {
+                    while (!util::endsWith(line, "*/"))
+                        next(line);
+                }
+
+                util::removeLineCommentInPlace(line);
+                enumClass->AddBody(line);
+
+                if (line == "};")
+                    break;
+            }
+
+            return enumClass;
+        }
+
+        StructClass* ExtractStructClass(const string& prototype, const string& templ, const string& annotations)
+        {
+            if (util::firstMatch(prototype, " [_a-zA-Z0-9]").position == -1)
+                util::syntaxError(lineNum, filename, "struct/class name expected");
+
+            StructClass* structClass = Own(new StructClass(prototype, storage->names.Intern(currentNamespace), templ));
+            string line;
+            string methodTempl; // template line of member function template
+            string methodAnnotations; // '// @profile' lines before method
+            structClass->SetAnnotations(annotations);
+            AccessSpecifier accSpecifier = AccessSpecifier::NoSpecifier;
+
+            // next line must be '{'
+            next(line);
+            util::removeLineCommentInPlace(line);
+
+            if (line != "{")
+                util::syntaxError(lineNum, filename, "missing '{'");
+
+            while (true)
+            {
+                next(line);
+                bool cold = util::hasAnnotation(line, "@cold");
+
+                if (util::startsWith(line, "//") && util::hasAnnotation(line, "@"))
+                    methodAnnotations += line;
+
+                util::removeLineCommentInPlace(line);
+
+                if (cold && !util::endsWith(line, ";"))
+                    util::syntaxError(lineNum, filename, "@cold can be used only with fields");
+
+                if (line == "private:")
+                    accSpecifier = AccessSpecifier::Private;
+                else if (line == "public:")
+                    accSpecifier = AccessSpecifier::Public;
+                else if (line == "protected:")
+                    accSpecifier = AccessSpecifier::Protected;
+                else if (line == "};")
+                    break;
+                else if (util::startsWith(line, "/*"))
+                {
+                    while (!util::endsWith(line, "*/"))
+                        next(line);
+                }       
+                else if (util::startsWith(line, "template"))
+                {
+                    methodTempl = line;
+                }
+                else if (util::endsWith(line, ";") && methodTempl.length() != 0)
+                {
+                    util::syntaxError(lineNum, filename, "template must be followed by method");
+                }
+                else if (util::endsWith(line, ";") && cold)
+                {
+                    if (util::startsWith(line, "static ") || util::startsWith(structClass->GetSimplePrototype(), "union"))
+                        util::syntaxError(lineNum, filename, "@cold field cannot be static or in union");
+
+                    Field* field = Own(new Field(line, structClass->GetColdName()));
+                    structClass->AddField(field, accSpecifier);
+                }
+                else if (util::endsWith(line, ";"))
+                {
+                    Field* field = Own(new Field(line));
+                    structClass->AddField(field, accSpecifier);
+                }
+                else if (util::endsWith(line, ")") || util::endsWith(line, ",") || util::endsWith(line, "const") || util::endsWith(line, "override"))
+                {
+                    // @profile before struct applies to all methods
+                    Method* m = ExtractMethod(line, structClass->GetName(), methodTempl, templ.length() != 0, annotations + methodAnnotations);
+                    methodTempl = "";
+                    structClass->AddMethod(m, accSpecifier);
+                }
+                else if (line.length() == 0)
+                {
+                }
+                else
+                    util::syntaxError(lineNum, filename, "unknown struct member");
+
+                // template line and comment lines dont consume annotations
+                if (line.length() != 0 && !util::startsWith(line, "template"))
+                    methodAnnotations = "";
+            }
+
+            return structClass;
+        }
+
+        void ExtractNamespace(string& line)
+        {
+            if (util::firstMatch(line, "^namespace [_a-zA-Z][_a-zA-Z0-9]*(::[_a-zA-Z][_a-zA-Z0-9]*)*$").position == -1)
+                util::syntaxError(lineNum, filename, "namespace name expected");
+
+            enterNamespace(line.substr(10));
+            string templ;
+            string annotations; // '// @...' lines, they apply to the next declaration
+
+            // match '{'
+            next(line);
+
+            if (line != "{")
+                util::syntaxError(lineNum, filename, "{ expected");
+
+            while (true)
+            {
+                next(line);
+
+                if (util::startsWith(line, "//") && util::hasAnnotation(line, "@"))
+                    annotations += line;
+
+                util::removeLineCommentInPlace(line);
+
+                // template line and comment lines dont consume annotations and template
+                bool declaration = line.length() != 0 && !util::startsWith(line, "template");
+
+                if (declaration && templ.length() != 0 && !util::startsWith(line, "class") && !util::startsWith(line, "struct")
+                    && !util::startsWith(line, "union") && !util::endsWith(line, ")") && !util::endsWith(line, ","))
+                    util::syntaxError(lineNum, filename, "template must be followed by struct, class or function");
+
+                if (util::startsWith(line, "using") || util::startsWith(line, "typedef"))
+                {
+                    Using* u = Own(new Using(line, storage->names.Intern(currentNamespace)));
+
+                    if (util::startsWith(line, "typedef") && u->GetName().length() == 0)
+                        util::syntaxError(lineNum, filename, "typedef name expected");
+
+                    usings.push_back(u);
+                    nodes.push_back(u);
+                }
+                else if (util::startsWith(line, "template"))
+                {
+                    templ = line;
+                }
+                else if (util::startsWith(line, "/*"))
+                {
+                    while (!util::endsWith(line, "*/"))
+                        next(line);
+                }
+                else if (util::endsWith(line, ";"))
+                {
+                    NsVariable* var = Own(new NsVariable(line, storage->names.Intern(currentNamespace)));
+                    variables.push_back(var);
+                    nodes.push_back(var);
+                }
+                else if (util::endsWith(line, ")") || util::endsWith(line, ","))
+                {
+                    // functions are ordered with structs that can use them and header only functions that call them
+                    nodes.push_back(Own(new FunctionNode(ExtractFunction(line, templ, annotations))));
+                }
+                else if (util::startsWith(line, "enum class"))
+                {                    
+                    EnumClass* e = ExtractEnumClass(line, annotations);
+                    enums.push_back(e);
+                    nodes.push_back(e);
+                }
+                else if (util::startsWith(line, "class") || util::startsWith(line, "struct") || util::startsWith(line, "union"))
+                {
+                    StructClass* s = ExtractStructClass(line, templ, annotations);
+
+                    if (s->HasAnnotation("@soa") && s->HasColdFields())
+                        util::syntaxError(lineNum, filename, "@soa struct cannot have @cold fields");
+
+                    if (s->HasAnnotation("@serializable") && s->HasColdFields())
+                        util::syntaxError(lineNum, filename, "@serializable struct cannot have @cold fields");
+
+                    // structs with the same name are not allowed
+                    if(util::contains<string,StructClass*>(structClasses, s->GetName()))
+                        throw std::runtime_error("structs with the same name are not allowed");
+
+                    structClasses[s->GetName()] = (s);
+                    nodes.push_back(s);
+                }
+                else if (line.length() == 0)
+                {
+                }
+                else if (util::startsWith(line, "namespace"))
+                {
+                    ExtractNamespace(line);
+                }
+                else if (line == "}")
+                {
+                    break;
+                }
+                else
+                {
+                    util::syntaxError(lineNum, filename, "unknown namespace element");
+                }
+
+                if (declaration)
+                {
+                    annotations = "";
+                    templ = "";
+                }
+            }
+
+            exitNamespace();
+        }
+
+        // parser entry point
+        void Program()
+        {
+            string line;
+
+            while (!next(line))
+            {
+                util::removeLineCommentInPlace(line);
+
+                if (util::startsWith(line, "#include"))
+                {
+                    for (const string& s : includes)
+                        if (s == line)
+                            continue;
+
+                    includes.push_back(line);
+                }
+                else if (util::startsWith(line, "#pragma comment") || util::startsWith(line, "#define"))
+                {
+                    includes.push_back(line);
+                }
+                else if (util::startsWith(line, "#pragma compileif"))
+                {
+                    if (lineNum != 1)
+                        throw std::runtime_error("#pragma compileif must be on the first line");
+                    else if (variantPart)
+                        condition = line.substr(18);
+                    else if (!CompileIf(line))
+                        return;
+                }
+                else if (util::startsWith(line, "/*"))
+                {
+                    while (!util::endsWith(line, "*/"))
+                        next(line);
+                }
+                else if (line.length() == 0)
+                {
+                }
+                else if (util::startsWith(line, "namespace"))
+                {
+                    ExtractNamespace(line);
+                }
+                else if (util::startsWith(line,"int main("))
+                {
+                    main = ExtractFunction(line, "", "");
+                }
+                else
+                {
+                    util::syntaxError(lineNum, filename, "unknown program element");
+                }
+            }
+            // dont put any code here
+        }
+
+        /////////////////// parser functions end
+
+        // "-" reads one file from stdin, "-0" reads bundles 'name\0content\0...' from stdin
+        void Collect(const string& filename)
+        {
+            if (filename == "-" || filename == "-0")
+            {
+                CollectFile(stdin, filename == "-0");
+                return;
+            }
+
+            if (Excluded(filename))
+                return;
+
+            std::ifstream file(filename);
+
+            if (!file.is_open())
+                throw std::runtime_error(("could not open " + filename).c_str());
+
+            CollectStream(file, filename);
+            file.close();
+        }
+
+        // '#pragma compileif expr' line
+        bool CompileIf(const string& line)
+        {
+            return util::evalFlags(line.substr(18), flags);
+        }
+
+        // pre screen with one small read of the first line, most files in variant builds are excluded by #pragma compileif
+        bool Excluded(const string& filename)
+        {
+            FILE* file = fopen(filename.c_str(), "rb");
+
+            if (file == nullptr)
+                throw std::runtime_error(("could not open " + filename).c_str());
+
+            char buffer[256];
+            setvbuf(file, nullptr, _IONBF, 0);
+            size_t size = fread(buffer, 1, sizeof(buffer), file);
+            fclose(file);
+
+            string line(buffer, size);
+            size_t end = line.find('\n');
+
+            // first line is too long, Program will check it
+            if (end == string::npos && size == sizeof(buffer))
+                return false;
+
+            line = line.substr(0, end);
+            if (line.length() > 0 && line.back() == '\r')
+                line.pop_back();
+
+            util::trimInPlace(line);
+            util::removeLineCommentInPlace(line);
+
+            return util::startsWith(line, "#pragma compileif") && !CompileIf(line);
+        }
+
+        // name is used in error messages
+        void CollectStream(std::istream& file, const string& name)
+        {
+            this->filename = name;
+            this->lineNum = 0;
+            this->ended = false;
+
+            next = [this, &file](string& str)
+            {
+                if (ended)
+                    util::syntaxError(lineNum, filename, "unexpected end of file");
+
+                std::getline(file, str);
+                lineNum++;
+
+                util::trimInPlace(str);
+                ended = file.eof();
+
+                return ended;
+            };
+
+            Program();
+        }
+
+        // one file or bundles (see Collect) read with LineReader
+        void CollectFile(FILE* file, bool bundles)
+        {
+            util::LineReader reader(file);
+
+            next = [this, &reader](string& str)
+            {
+                if (ended)
+                    util::syntaxError(lineNum, filename, "unexpected end of file");
+
+                int end = reader.ReadLine(str);
+                lineNum++;
+
+                util::trimInPlace(str);
+                ended = end != '\n';
+
+                return ended;
+            };
+
+            if (!bundles)
+            {
+                this->filename = "<stdin>";
+                this->lineNum = 0;
+                this->ended = false;
+                Program();
+                return;
+            }
+
+            string name;
+            while (reader.ReadLine(name) == '\0')
+            {
+                reader.NextSegment();
+                this->filename = name;
+                this->lineNum = 0;
+                this->ended = false;
+
+                Program();
+
+                // rest of file excluded by #pragma compileif
+                reader.SkipSegment();
+                reader.NextSegment();
+            }
+
+            if (name.length() != 0)
+                throw std::runtime_error(("bundle without content " + name).c_str());
+        }
+
+        // settings only, constructors above collect files
+        Monolith(const Options& options, std::ostream* source):
+            lineNum(0), flags(options.flags.begin(), options.flags.end()), main(nullptr), streamSource(source),
+            lineDirectives(options.lineDirectives), sourceFile(options.sourceFile), profile(options.profile), profiled(false),
+            threads(options.threads > 0 ? options.threads : std::max(1, (int)std::thread::hardware_concurrency())), variantPart(false),
+            storage(std::make_shared<Storage>())
+        {
+            if (profile.length() != 0)
+                profileFilter = std::regex(profile);
+
+            if (lineDirectives && sourceFile.length() == 0)
+                throw std::runtime_error("#line directives need Options::sourceFile");
+
+            if (source != nullptr)
+                streamSource = &Restored(*source, 0);
+        }
+
+        // with #line directives source is written through LineRestorer, one per stream so its lines are counted from start
+        std::ostream& Restored(std::ostream& source, int shard)
+        {
+            if (!lineDirectives)
+                return source;
+
+            std::unique_ptr<util::LineRestorer>& restorer = restorers[&source];
+
+            if (restorer == nullptr)
+                restorer.reset(new util::LineRestorer(source, shard == 0 ? sourceFile : util::variantFileName(sourceFile, std::to_string(shard))));
+
+            return *restorer;
+        }
+
+        // body gets profile scope if it is annotated with @profile or its name matches Options::profile
+        // constexpr/consteval bodies cannot have it
+        bool Profiled(BaseFunc* f, const string& annotations)
+        {
+            if (f->IsCompileTime())
+                return false;
+
+            return util::hasAnnotation(annotations, "@profile") || (profile.length() != 0 && std::regex_search(f->GetQualifiedName(), profileFilter));
+        }
+
+        // profile scope goes on the line of '{' so #line stays right
+        string BodyBegin(BaseFunc* f, const string& line, const string& annotations)
+        {
+            if (!Profiled(f, annotations))
+                return line;
+
+            profiled = true;
+
+            return line + " MONOLITH_PROFILE_SCOPE(\"" + f->GetQualifiedName() + "\");";
+        }
+
+        // adds include needed by generated code unless it is already there
+        void AddInclude(const string& include)
+        {
+            if (std::find(includes.begin(), includes.end(), include) == includes.end())
+                includes.push_back(include);
+        }
+
+        void DependencyOrder()
+        {
+            // 1. find dependencies, names are not unique across namespaces so name can map to more nodes
+            std::unordered_map<string, vector<Node*>> names;
+            for (Node* n : nodes)
+            {
+                n->ResetOrder();
+
+                if (n->GetName().length() != 0)
+                    names[n->GetName()].push_back(n);
+            }
+
+            for (Node* n : nodes)
+                n->FindDependencies(names);
+
+            // 2. start all dependencies traversal in parse order
+            // if there are no dependencies then just copy to ordered
+            // if there is then do DFS to the bottom and copy on the way back
+            // if there is a cycle then throw exception
+            for (Node* n : nodes)
+                n->Traverse(orderedNodes);
+        }
+    public:
+        // ctor is the main driver, it will produce IR of all C++ source files
+        // if source is given, function bodies are written to it while parsing and are not kept in IR
+        // then Dump() must get the same source stream and hfile
+        Monolith(const vector<string>& filenames, const Options& options, std::ostream* source = nullptr):
+            Monolith(options, source)
+        {
+            if (streamSource != nullptr)
+            {
+                *streamSource << "#include \"" << options.hfile << "\"" << std::endl;
+                *streamSource << std::endl;
+            }
+
+            for (const string& s : filenames)
+                Collect(s);
+
+            DependencyOrder();
+        }
+
+        // IR of one file or bundles (see Collect) read from FILE*, bodies go to source as they are parsed
+        Monolith(FILE* file, bool bundles, const Options& options, std::ostream& source):
+            Monolith(options, &source)
+        {
+            *streamSource << "#include \"" << options.hfile << "\"" << std::endl;
+            *streamSource << std::endl;
+
+            CollectFile(file, bundles);
+
+            DependencyOrder();
+        }
+
+        // IR of in memory files
+        Monolith(const vector<InputFile>& files, const Options& options):
+            Monolith(options, nullptr)
+        {
+            for (const InputFile& f : files)
+            {
+                std::istringstream file(f.content);
+                CollectStream(file, f.name);
+            }
+
+            DependencyOrder();
+        }
+
+        // IR of one in memory file for GenerateVariants, file is parsed whatever its #pragma compileif is
+        // and its condition is kept, there is no dependency order because parts are merged first
+        Monolith(const InputFile& file, const Options& options):
+            Monolith(options, nullptr)
+        {
+            variantPart = true;
+
+            std::istringstream stream(file.content);
+            CollectStream(stream, file.name);
+        }
+
+        // IR of variant parts whose condition is true for options.flags, parts are in file order
+        // nodes are shared, the result is the same as if only those files were parsed
+        Monolith(const vector<std::unique_ptr<Monolith>>& parts, const Options& options):
+            Monolith(options, nullptr)
+        {
+            for (const std::unique_ptr<Monolith>& part : parts)
+            {
+                if (part->condition.length() != 0 && !util::evalFlags(part->condition, flags))
+                    continue;
+
+                // nodes stay valid even if part is destroyed first
+                partStorage.push_back(part->storage);
+
+                includes.insert(includes.end(), part->includes.begin(), part->includes.end());
+                variables.insert(variables.end(), part->variables.begin(), part->variables.end());
+                enums.insert(enums.end(), part->enums.begin(), part->enums.end());
+                usings.insert(usings.end(), part->usings.begin(), part->usings.end());
+                nodes.insert(nodes.end(), part->nodes.begin(), part->nodes.end());
+
+                // same order of inserts as in one parse
+                for (Node* n : part->nodes)
+                {
+                    if (!n->IsStruct())
+                        continue;
+
+                    if (util::contains<string, StructClass*>(structClasses, n->GetName()))
+                        throw std::runtime_error("structs with the same name are not allowed");
+
+                    structClasses[n->GetName()] = part->structClasses.at(n->GetName());
+                }
+
+                if (part->main != nullptr)
+                    main = part->main;
+
+                profiled = profiled || part->profiled;
+            }
+
+            DependencyOrder();
+        }
+
+        // output IR
+        void Dump(std::ostream& header, std::ostream& source, const string& hfile)
+        {
+            Dump(header, vector<std::ostream*>{ &source }, hfile);
+        }
+
+        // '#pragma once', includes, defines and generated preambles (reflect, serial, pool, profile)
+        void DumpPreamble(std::ostream& header)
+        {
+            header << "#pragma once" << std::endl;
+
+            bool reflect = false;
+            bool serial = false;
+            bool pooled = false;
+
+            for (auto& sc : structClasses)
+            {
+                // companion structs of @cold fields are held by unique_ptr
+                if (sc.second->HasColdFields())
+                    AddInclude("#include <memory>");
+
+                // struct of arrays containers
+                if (sc.second->HasAnnotation("@soa"))
+                    AddInclude("#include <vector>");
+
+                reflect = reflect || sc.second->HasAnnotation("@reflect");
+                serial = serial || sc.second->HasAnnotation("@serializable");
+                pooled = pooled || sc.second->HasAnnotation("@pooled");
+            }
+
+            for (EnumClass* e : enums)
+                reflect = reflect || e->IsReflected();
+
+            if (reflect)
+            {
+                for (const char* inc : { "#include <cstddef>", "#include <cstdint>", "#include <string_view>", "#include <tuple>" })
+                    AddInclude(inc);
+            }
+
+            if (serial)
+            {
+                for (const char* inc : { "#include <cstddef>", "#include <cstdint>", "#include <cstring>", "#include <string>", "#include <type_traits>", "#include <vector>" })
+                    AddInclude(inc);
+            }
+
+            if (pooled)
+            {
+                for (const char* inc : { "#include <cstddef>", "#include <cstdint>", "#include <new>" })
+                    AddInclude(inc);
+            }
+
+            if (profiled)
+            {
+                for (const char* inc : { "#include <atomic>", "#include <chrono>", "#include <cstdint>", "#include <mutex>", "#include <ostream>", "#include <vector>" })
+                    AddInclude(inc);
+            }
+
+            for (string& s : includes)
+                header << s << std::endl;
+
+            header << '\n';
+
+            if (reflect)
+                util::dumpReflectPreamble(header);
+
+            if (serial)
+                util::dumpSerialPreamble(header);
+
+            if (pooled)
+                util::dumpPoolPreamble(header);
+
+            if (profiled)
+                util::dumpProfilePreamble(header);
+        }
+
+        // source is split to shards that can be compiled in parallel, each of them includes hfile
+        // streamed bodies are in the first shard
+        void Dump(std::ostream& header, const vector<std::ostream*>& sourceFiles, const string& hfile)
+        {
+            vector<std::ostream*> sources;
+            for (int i = 0; i < (int)sourceFiles.size(); i++)
+                sources.push_back(&Restored(*sourceFiles.at(i), i));
+
+            DumpPreamble(header);
+
+            for (int i = 0; i < (int)sources.size(); i++)
+            {
+                // already there when bodies are streamed
+                if (i == 0 && streamSource != nullptr)
+                    continue;
+
+                *sources.at(i) << "#include \"" << hfile << "\"" << std::endl;
+                *sources.at(i) << std::endl;
+            }
+            
+            DumpForwardDeclaration(header);
+            
+            // dump main
+            if(main != nullptr)
+                main->Dump(header, *sources.at(0));
+
+            Dump2(header, sources);
+
+            // blocks left open by the last declarations
+            util::closeNamespace(header);
+            for (std::ostream* s : sources)
+            {
+                util::closeNamespace(*s);
+                s->flush();
+            }
+        }
+
+        // what sharing namespace blocks saved in streams written by Dump()
+        void DumpStats(std::ostream& header, const vector<std::ostream*>& sources, std::ostream& report)
+        {
+            vector<std::ostream*> streams(sources);
+            streams.push_back(&header);
+
+            size_t merged = 0;
+            size_t saved = 0;
+            long long written = 0;
+
+            for (int i = 0; i < (int)streams.size(); i++)
+            {
+                // blocks are counted in stream Dump() wrote to
+                std::ostream* s = streams.at(i);
+                std::ostream& blocks = i < (int)sources.size() ? Restored(*s, i) : *s;
+
+                merged += util::namespaceBlock(blocks).merged;
+                saved += util::namespaceBlock(blocks).saved;
+                written += std::max((long long)s->tellp(), 0LL);
+            }
+
+            char percent[32];
+            snprintf(percent, sizeof(percent), "%.1f", written + saved == 0 ? 0.0 : 100.0 * saved / (written + saved));
+
+            report << "namespace blocks merged " << merged << ", " << saved << " bytes saved (" << percent << "% of output)" << std::endl;
+        }
+
+        // one line per declaration 'kind interfaceHash bodyHash name'
+        // interface hash covers what goes to header, body hash what goes only to source
+        void DumpManifest(std::ostream& manifest)
+        {
+            // header changes with includes/defines and preambles too, all its dependents must be rebuilt
+            std::ostringstream preamble;
+            DumpPreamble(preamble);
+            util::dumpManifestLine(manifest, "preamble", util::hash64(preamble.str()), util::hash64(""), "header");
+
+            for (Node* n : nodes)
+                n->DumpManifest(manifest);
+
+            if (main != nullptr)
+                main->DumpManifest(manifest);
+        }
+
+        // compares with manifest of previous run, one line per changed declaration:
+        // 'interface kind name' header changed so its dependents must be rebuilt, 'body kind name' only source changed
+        // 'added kind name' and 'removed kind name'
+        void DumpDiff(std::istream& previous, std::ostream& report)
+        {
+            std::stringstream manifest;
+            DumpManifest(manifest);
+
+            vector<util::ManifestEntry> before = util::readManifest(previous);
+            vector<util::ManifestEntry> after = util::readManifest(manifest);
+
+            std::unordered_map<string, util::ManifestEntry*> old;
+            for (util::ManifestEntry& e : before)
+                old[e.key] = &e;
+
+            for (util::ManifestEntry& e : after)
+            {
+                auto it = old.find(e.key);
+
+                if (it == old.end())
+                    report << "added " << e.key << std::endl;
+                else
+                {
+                    if (it->second->interfaceHash != e.interfaceHash)
+                        report << "interface " << e.key << std::endl;
+                    else if (it->second->bodyHash != e.bodyHash)
+                        report << "body " << e.key << std::endl;
+
+                    old.erase(it);
+                }
+            }
+
+            for (util::ManifestEntry& e : before)
+                if (old.count(e.key) != 0)
+                    report << "removed " << e.key << std::endl;
+        }
+
+        void DumpForwardDeclaration(std::ostream& header)
+        {
+            for (Node* n : orderedNodes)
+                n->DumpForwardDecl(header);
+        }
+
+        // nodes go to shards round robin
+        // big IRs are rendered in parallel, each node to its own buffers, buffers are written in the same order
+        void Dump2(std::ostream& header, const vector<std::ostream*>& sources)
+        {
+            vector<IDump*> items(orderedNodes.begin(), orderedNodes.end());
+
+            // threads are not worth it for less than 64 nodes each
+            int count = std::min(threads, (int)items.size() / 64);
+
+            if (count > 1)
+            {
+                vector<std::ostringstream> headers(items.size());
+                vector<std::ostringstream> bodies(items.size());
+                vector<std::exception_ptr> errors(items.size());
+                std::atomic<size_t> nextItem(0);
+
+                auto work = [&]()
+                {
+                    for (size_t i = nextItem++; i < items.size(); i = nextItem++)
+                    {
+                        try
+                        {
+                            items.at(i)->Dump(headers.at(i), bodies.at(i));
+                        }
+                        catch (...)
+                        {
+                            errors.at(i) = std::current_exception();
+                        }
+                    }
+                };
+
+                vector<std::thread> workers;
+                for (int i = 1; i < count; i++)
+                    workers.emplace_back(work);
+
+                work();
+
+                for (std::thread& t : workers)
+                    t.join();
+
+                // first error in output order, same as single threaded
+                for (size_t i = 0; i < items.size(); i++)
+                {
+                    if (errors.at(i))
+                        std::rethrow_exception(errors.at(i));
+
+                    util::appendNamespaced(header, headers.at(i));
+                    util::appendNamespaced(*sources.at(i % sources.size()), bodies.at(i));
+                }
+
+                return;
+            }
+
+            int shard = 0;
+
+            // usings, enums, structs, variables and functions
+            for (IDump* i : orderedNodes)
+            {
+                i->Dump(header, *sources.at(shard));
+                shard = (shard + 1) % sources.size();
+            }
+        }
+    };
+
+    struct Output
+    {
+        string header;
+        vector<string> sources; // one per shard
+    };
+
+    // IR to in memory header and sources
+    inline Output DumpOutput(Monolith& mono, const Options& options)
+    {
+        std::ostringstream header;
+        vector<std::ostringstream> sources(options.shards);
+        vector<std::ostream*> sourcePtrs;
+        for (auto& s : sources)
+            sourcePtrs.push_back(&s);
+
+        mono.Dump(header, sourcePtrs, options.hfile);
+
+        Output output;
+        output.header = header.str();
+        for (auto& s : sources)
+            output.sources.push_back(s.str());
+
+        return output;
+    }
+
+    // library entry point, in memory files to in memory header and sources
+    // throws std::runtime_error on errors just like Monolith
+    inline Output Generate(const vector<InputFile>& files, const Options& options)
+    {
+        if (options.shards < 1)
+            throw std::runtime_error("Generate() shards must be at least 1");
+
+        Monolith mono(files, options);
+
+        return DumpOutput(mono, options);
+    }
+
+    struct Variant
+    {
+        string name; // e.g. 'debug', it is put in hfile name e.g. 'out.debug.h'
+        vector<string> flags; // for #pragma compileif
+    };
+
+    // outputs for more flag sets with one parse, every file is parsed once whatever its #pragma compileif is
+    // and each variant gets IR of files whose condition is true for its flags (options.flags are not used)
+    // unlike separate runs, files must parse even if no variant uses them
+    inline vector<Output> GenerateVariants(const vector<InputFile>& files, const vector<Variant>& variants, const Options& options)
+    {
+        if (options.shards < 1)
+            throw std::runtime_error("GenerateVariants() shards must be at least 1");
+
+        vector<std::unique_ptr<Monolith>> parts;
+        for (const InputFile& f : files)
+            parts.emplace_back(new Monolith(f, options));
+
+        vector<Output> outputs;
+
+        for (const Variant& v : variants)
+        {
+            Options variantOptions(options);
+            variantOptions.flags = v.flags;
+
+            if (options.hfile.length() != 0)
+                variantOptions.hfile = util::variantFileName(options.hfile, v.name);
+
+            if (options.sourceFile.length() != 0)
+                variantOptions.sourceFile = util::variantFileName(options.sourceFile, v.name);
+
+            Monolith mono(parts, variantOptions);
+            outputs.push_back(DumpOutput(mono, variantOptions));
+        }
+
+        return outputs;
+    }
+}